@@ -0,0 +1,294 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "ExrWriter.h"
+
+#ifdef RPRUSD_EXR_ZLIB
+#include <zlib.h>
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// OpenEXR file layout constants, see "OpenEXR File Layout" document.
+// All values are stored little endian, same as on x64.
+static const int32_t kExrMagic = 20000630;
+static const int32_t kExrVersion = 2;
+static const int32_t kExrLongNamesFlag = 0x400;
+static const int32_t kExrPixelTypeUInt = 0;
+static const int32_t kExrPixelTypeFloat = 2;
+
+#ifdef RPRUSD_EXR_ZLIB
+static const uint8_t kExrCompression = 2; // ZIPS, one scanline per chunk
+// Level OpenEXR uses by default, higher ones barely shrink float data further
+static const int kZipLevel = 4;
+#else
+static const uint8_t kExrCompression = 0;
+#endif
+
+namespace {
+
+class ExrHeaderBuilder
+{
+public:
+    template <typename T> void Add(const T& value)
+    {
+        const char* bytes = reinterpret_cast<const char*>(&value);
+        _data.insert(_data.end(), bytes, bytes + sizeof(T));
+    }
+
+    void AddString(const std::string& str)
+    {
+        _data.insert(_data.end(), str.begin(), str.end());
+        _data.push_back('\0');
+    }
+
+    void AddAttribute(const std::string& name, const std::string& type, const std::vector<char>& value)
+    {
+        AddString(name);
+        AddString(type);
+        Add<int32_t>((int32_t)value.size());
+        _data.insert(_data.end(), value.begin(), value.end());
+    }
+
+    std::vector<char>& GetData() { return _data; }
+
+private:
+    std::vector<char> _data;
+};
+
+#ifdef RPRUSD_EXR_ZLIB
+
+// ZIP compression of OpenEXR: low and high bytes are split into two halves, delta encoded
+// and deflated. Returns false when the data doesn't get smaller, it is stored raw then.
+bool CompressZip(const std::vector<char>& raw, std::vector<char>& zip, std::vector<char>& packed)
+{
+    const size_t size = raw.size();
+    zip.resize(size);
+
+    char* half1 = zip.data();
+    char* half2 = zip.data() + (size + 1) / 2;
+    for (size_t i = 0; i < size; ++i) {
+        if (i % 2 == 0) {
+            *half1++ = raw[i];
+        } else {
+            *half2++ = raw[i];
+        }
+    }
+
+    unsigned char* bytes = reinterpret_cast<unsigned char*>(zip.data());
+    int            previous = size > 0 ? bytes[0] : 0;
+    for (size_t i = 1; i < size; ++i) {
+        const int current = bytes[i];
+        bytes[i] = (unsigned char)(current - previous + (128 + 256));
+        previous = current;
+    }
+
+    uLongf packedSize = compressBound((uLong)size);
+    packed.resize(packedSize);
+    if (compress2(
+            reinterpret_cast<Bytef*>(packed.data()),
+            &packedSize,
+            reinterpret_cast<const Bytef*>(zip.data()),
+            (uLong)size,
+            kZipLevel)
+            != Z_OK
+        || packedSize >= size) {
+        return false;
+    }
+
+    packed.resize(packedSize);
+    return true;
+}
+
+#endif
+
+} // namespace
+
+ExrWriter::~ExrWriter() { Close(); }
+
+bool ExrWriter::Open(
+    const std::string&              path,
+    unsigned int                    width,
+    unsigned int                    height,
+    const std::vector<std::string>& channelNames,
+    const std::vector<bool>&        uintChannels)
+{
+    Close();
+
+    if (width == 0 || height == 0 || channelNames.empty()
+        || (!uintChannels.empty() && uintChannels.size() != channelNames.size())) {
+        return false;
+    }
+
+    _file.open(path, std::ios::binary | std::ios::out | std::ios::trunc);
+    if (!_file.is_open()) {
+        return false;
+    }
+
+    _width = width;
+    _height = height;
+
+    // Channels must be sorted by name in the channel list and in the scanline data
+    _channelOrder.resize(channelNames.size());
+    std::iota(_channelOrder.begin(), _channelOrder.end(), 0);
+    std::sort(_channelOrder.begin(), _channelOrder.end(), [&](size_t a, size_t b) {
+        return channelNames[a] < channelNames[b];
+    });
+
+    bool longNames = false;
+
+    ExrHeaderBuilder channelList;
+    for (size_t index : _channelOrder) {
+        longNames = longNames || channelNames[index].size() > 31;
+
+        channelList.AddString(channelNames[index]);
+        const bool isUInt = !uintChannels.empty() && uintChannels[index];
+        channelList.Add<int32_t>(isUInt ? kExrPixelTypeUInt : kExrPixelTypeFloat);
+        channelList.Add<uint8_t>(0); // pLinear
+        channelList.Add<uint8_t>(0); // reserved
+        channelList.Add<uint8_t>(0);
+        channelList.Add<uint8_t>(0);
+        channelList.Add<int32_t>(1); // xSampling
+        channelList.Add<int32_t>(1); // ySampling
+    }
+    channelList.Add<uint8_t>(0);
+
+    ExrHeaderBuilder window;
+    window.Add<int32_t>(0);
+    window.Add<int32_t>(0);
+    window.Add<int32_t>((int32_t)width - 1);
+    window.Add<int32_t>((int32_t)height - 1);
+
+    ExrHeaderBuilder compression;
+    compression.Add<uint8_t>(kExrCompression);
+
+    ExrHeaderBuilder increasingY;
+    increasingY.Add<uint8_t>(0);
+
+    ExrHeaderBuilder one;
+    one.Add<float>(1.0f);
+
+    ExrHeaderBuilder screenWindowCenter;
+    screenWindowCenter.Add<float>(0.0f);
+    screenWindowCenter.Add<float>(0.0f);
+
+    ExrHeaderBuilder header;
+    header.Add<int32_t>(kExrMagic);
+    header.Add<int32_t>(kExrVersion | (longNames ? kExrLongNamesFlag : 0));
+    header.AddAttribute("channels", "chlist", channelList.GetData());
+    header.AddAttribute("compression", "compression", compression.GetData());
+    header.AddAttribute("dataWindow", "box2i", window.GetData());
+    header.AddAttribute("displayWindow", "box2i", window.GetData());
+    header.AddAttribute("lineOrder", "lineOrder", increasingY.GetData());
+    header.AddAttribute("pixelAspectRatio", "float", one.GetData());
+    header.AddAttribute("screenWindowCenter", "v2f", screenWindowCenter.GetData());
+    header.AddAttribute("screenWindowWidth", "float", one.GetData());
+    header.Add<uint8_t>(0);
+
+    // Compressed lines differ in size, the offset table is filled on Close
+    _lineOffsetTableOffset = (std::streamoff)header.GetData().size();
+    _lineOffsets.assign(height, 0);
+    for (unsigned int y = 0; y < height; ++y) {
+        header.Add<uint64_t>(0);
+    }
+
+    _file.write(header.GetData().data(), header.GetData().size());
+
+    // UINT and FLOAT samples are both 4 bytes
+    _lineBuffer.resize(size_t(width) * channelNames.size() * sizeof(float));
+
+    return _file.good();
+}
+
+bool ExrWriter::WriteScanline(unsigned int y, const float* pixels)
+{
+    if (!_file.is_open() || y >= _height) {
+        return false;
+    }
+
+    const size_t channelCount = _channelOrder.size();
+
+    // Samples are copied as bits, UINT values must not go through float conversion
+    const uint32_t* inData = reinterpret_cast<const uint32_t*>(pixels);
+    uint32_t*       outData = reinterpret_cast<uint32_t*>(_lineBuffer.data());
+    for (size_t c = 0; c < channelCount; ++c) {
+        const size_t channelIndex = _channelOrder[c];
+        uint32_t*    outChannel = outData + c * _width;
+
+        for (unsigned int x = 0; x < _width; ++x) {
+            outChannel[x] = inData[size_t(x) * channelCount + channelIndex];
+        }
+    }
+
+    return WriteLineBuffer(y);
+}
+
+bool ExrWriter::WriteLineBuffer(unsigned int y)
+{
+    const char* data = _lineBuffer.data();
+    int32_t     dataSize = int32_t(_lineBuffer.size());
+
+#ifdef RPRUSD_EXR_ZLIB
+    if (CompressZip(_lineBuffer, _zipBuffer, _packedBuffer)) {
+        data = _packedBuffer.data();
+        dataSize = int32_t(_packedBuffer.size());
+    }
+#endif
+
+    // Chunks are appended in the order lines come, the offset table points at each of them
+    _file.seekp(0, std::ios::end);
+    _lineOffsets[y] = uint64_t(_file.tellp());
+
+    const int32_t line = int32_t(y);
+    _file.write(reinterpret_cast<const char*>(&line), sizeof(line));
+    _file.write(reinterpret_cast<const char*>(&dataSize), sizeof(dataSize));
+    _file.write(data, dataSize);
+
+    return _file.good();
+}
+
+bool ExrWriter::Close()
+{
+    if (!_file.is_open()) {
+        return false;
+    }
+
+    // Readers need a chunk for every line
+    std::fill(_lineBuffer.begin(), _lineBuffer.end(), char(0));
+    for (unsigned int y = 0; y < _height && _file.good(); ++y) {
+        if (_lineOffsets[y] == 0) {
+            WriteLineBuffer(y);
+        }
+    }
+
+    _file.seekp(_lineOffsetTableOffset);
+    _file.write(
+        reinterpret_cast<const char*>(_lineOffsets.data()),
+        _lineOffsets.size() * sizeof(uint64_t));
+
+    bool succeeded = _file.good();
+    _file.close();
+    _lineBuffer.clear();
+    _zipBuffer.clear();
+    _packedBuffer.clear();
+    _lineOffsets.clear();
+    _channelOrder.clear();
+
+    return succeeded;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,74 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef __RPRUSDEXRWRITER__
+#define __RPRUSDEXRWRITER__
+
+#include <pxr/pxr.h>
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/**
+ * Minimal writer of scanline OpenEXR files with any number of float channels.
+ * HioImage can only write a single RGBA layer, this one is used for multi-layer AOV output.
+ * Every scanline is its own chunk, ZIPS compressed when built with zlib and stored raw
+ * otherwise, so lines may be written in any order without keeping the whole image in memory.
+ */
+class ExrWriter
+{
+public:
+    ExrWriter() = default;
+    ~ExrWriter();
+
+    /** Create the file and write header and line offset table. Channel names are like "R" or
+     * "normal.X", they are reordered alphabetically in the file as the format requires.
+     * Channels set in uintChannels are stored as UINT, the rest as FLOAT. */
+    bool Open(
+        const std::string&              path,
+        unsigned int                    width,
+        unsigned int                    height,
+        const std::vector<std::string>& channelNames,
+        const std::vector<bool>&        uintChannels = {});
+
+    /** Write scanline y (0 is the top line). Pixels are interleaved in the order of channel
+     * names passed to Open, width * channelCount values. Values of UINT channels are the bits
+     * of uint32 stored in the float. */
+    bool WriteScanline(unsigned int y, const float* pixels);
+
+    /** Write lines that were never written as black and the line offset table. */
+    bool Close();
+
+    unsigned int GetChannelCount() const { return (unsigned int)_channelOrder.size(); }
+
+private:
+    bool WriteLineBuffer(unsigned int y);
+
+    std::ofstream         _file;
+    unsigned int          _width = 0;
+    unsigned int          _height = 0;
+    std::vector<size_t>   _channelOrder;
+    std::streamoff        _lineOffsetTableOffset = 0;
+    std::vector<uint64_t> _lineOffsets;
+    std::vector<char>     _lineBuffer;
+    std::vector<char>     _zipBuffer;
+    std::vector<char>     _packedBuffer;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif //__RPRUSDEXRWRITER__
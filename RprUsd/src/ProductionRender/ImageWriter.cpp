@@ -0,0 +1,457 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "ImageWriter.h"
+
+#include "ExrWriter.h"
+
+#include <maya/MGlobal.h>
+#include <maya/MString.h>
+#include <maya/MTimerMessage.h>
+
+#pragma warning(push, 0)
+
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/tf/pathUtils.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/imaging/hio/image.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+static const float kReportTimerPeriod = 0.1f;
+
+// Check the size in the header of a scanline EXR and that its last chunk is within the file.
+// Used when Hio has no EXR plugin to open the file.
+static bool _CheckExrHeader(
+    const std::string& path,
+    int64_t            fileSize,
+    unsigned int       width,
+    unsigned int       height)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+
+    int32_t magic = 0;
+    int32_t version = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    file.read(reinterpret_cast<char*>(&version), sizeof(version));
+
+    // Multi-part and deep files are never written by the renderer
+    const int32_t kTiledFlag = 0x200;
+    const int32_t kNonImageFlag = 0x800;
+    const int32_t kMultiPartFlag = 0x1000;
+    if (!file || magic != 20000630 || (version & (kNonImageFlag | kMultiPartFlag))) {
+        return false;
+    }
+
+    int32_t dataWindow[4] = { 0, 0, -1, -1 };
+    int     compression = -1;
+
+    // Attributes are name, type, size and value, empty name ends the header
+    while (true) {
+        std::string name;
+        std::string type;
+        int32_t     size = 0;
+
+        std::getline(file, name, '\0');
+        if (!file) {
+            return false;
+        }
+        if (name.empty()) {
+            break;
+        }
+
+        std::getline(file, type, '\0');
+        file.read(reinterpret_cast<char*>(&size), sizeof(size));
+        if (!file || size < 0) {
+            return false;
+        }
+
+        if (name == "dataWindow" && type == "box2i" && size == sizeof(dataWindow)) {
+            file.read(reinterpret_cast<char*>(dataWindow), sizeof(dataWindow));
+        } else if (name == "compression" && size == 1) {
+            compression = file.get();
+        } else {
+            file.seekg(size, std::ios::cur);
+        }
+    }
+
+    if (dataWindow[2] - dataWindow[0] + 1 != int64_t(width)
+        || dataWindow[3] - dataWindow[1] + 1 != int64_t(height)) {
+        return false;
+    }
+
+    // Offset table of tiled files depends on their levels, only the header is checked
+    if (version & kTiledFlag) {
+        return true;
+    }
+
+    // Scanlines per chunk of NONE, RLE, ZIPS, ZIP, PIZ, PXR24, B44, B44A, DWAA, DWAB
+    static const unsigned int kLinesPerChunk[] = { 1, 1, 1, 16, 32, 16, 32, 32, 32, 256 };
+    if (compression < 0 || compression >= int(sizeof(kLinesPerChunk) / sizeof(unsigned int))) {
+        return false;
+    }
+
+    // Offset table is written before the pixels, a truncated file has chunks past its end
+    const unsigned int chunkCount
+        = (height + kLinesPerChunk[compression] - 1) / kLinesPerChunk[compression];
+    uint64_t lastChunkOffset = 0;
+    for (unsigned int i = 0; i < chunkCount; ++i) {
+        uint64_t offset = 0;
+        file.read(reinterpret_cast<char*>(&offset), sizeof(offset));
+        if (!file || offset == 0 || offset >= uint64_t(fileSize)) {
+            return false;
+        }
+        lastChunkOffset = std::max(lastChunkOffset, offset);
+    }
+
+    // Chunk is its scanline, data size and data
+    int32_t chunkHeader[2] = { 0, 0 };
+    file.seekg(std::streamoff(lastChunkOffset));
+    file.read(reinterpret_cast<char*>(chunkHeader), sizeof(chunkHeader));
+
+    return file && chunkHeader[1] >= 0
+        && lastChunkOffset + sizeof(chunkHeader) + uint64_t(chunkHeader[1]) <= uint64_t(fileSize);
+}
+
+ImageWriter::ImageWriter()
+    : _jobsInProgress(0)
+    , _stop(false)
+    , _writeChecksums(false)
+{
+    // Encoding is mostly IO and compression bound, a few threads are enough to keep up with the
+    // renderer and leave the rest of the CPU to hdRPR
+    unsigned int threadCount
+        = std::max(1u, std::min(4u, std::thread::hardware_concurrency() / 4));
+
+    // Bound memory used by frames waiting to be written
+    _maxQueuedJobs = threadCount * 2;
+
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        _workers.emplace_back(&ImageWriter::WorkerLoop, this);
+    }
+}
+
+ImageWriter::~ImageWriter()
+{
+    RemoveReportTimer();
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _jobAdded.notify_all();
+
+    // Workers drain the queue before exiting, so no frame is lost on plugin unload
+    for (std::thread& worker : _workers) {
+        worker.join();
+    }
+
+    ReportErrors();
+}
+
+bool ImageWriter::IsSupportedFormat(const std::string& path)
+{
+    return HioImage::IsSupportedImageFile(path);
+}
+
+bool ImageWriter::IsMultiLayerFormat(const std::string& path)
+{
+    return TfStringToLower(TfGetExtension(path)) == "exr";
+}
+
+bool ImageWriter::IsValidImage(
+    const std::string& path,
+    unsigned int       width,
+    unsigned int       height,
+    bool               requireChecksum)
+{
+    const int64_t fileSize = ArchGetFileLength(path.c_str());
+    if (fileSize <= 0) {
+        return false;
+    }
+
+    // Truncated file may still have a valid header, only the checksum catches it
+    bool          hasChecksum = false;
+    std::ifstream checksumFile(GetChecksumPath(path));
+    if (checksumFile.is_open()) {
+        int64_t     expectedSize = -1;
+        std::string expectedHash;
+        checksumFile >> expectedSize >> expectedHash;
+
+        if (expectedSize != fileSize || expectedHash != ComputeFileHash(path)) {
+            return false;
+        }
+        hasChecksum = true;
+    } else if (requireChecksum) {
+        return false;
+    }
+
+    HioImageSharedPtr image = HioImage::OpenForReading(path);
+    if (image) {
+        return image->GetWidth() == int(width) && image->GetHeight() == int(height);
+    }
+
+    // Hio may have no plugin for the format, e.g. EXR without OpenEXR or Maya IFF
+    if (IsMultiLayerFormat(path)) {
+        return _CheckExrHeader(path, fileSize, width, height);
+    }
+
+    // Size can't be read, the file is trusted only if the checksum proves it complete
+    return hasChecksum;
+}
+
+bool ImageWriter::WriteChecksum(const std::string& path)
+{
+    const int64_t fileSize = ArchGetFileLength(path.c_str());
+    if (fileSize <= 0) {
+        return false;
+    }
+
+    std::ofstream checksumFile(GetChecksumPath(path), std::ios::out | std::ios::trunc);
+    if (!checksumFile.is_open()) {
+        return false;
+    }
+
+    checksumFile << fileSize << ' ' << ComputeFileHash(path) << '\n';
+    return checksumFile.good();
+}
+
+std::string ImageWriter::GetChecksumPath(const std::string& path) { return path + ".chk"; }
+
+std::string ImageWriter::GetPartialImagePath(const std::string& path)
+{
+    const std::string extension = TfGetExtension(path);
+    if (extension.empty()) {
+        return path + ".partial";
+    }
+
+    return path.substr(0, path.size() - extension.size() - 1) + ".partial." + extension;
+}
+
+std::string ImageWriter::ComputeFileHash(const std::string& path)
+{
+    std::ifstream file(path, std::ios::in | std::ios::binary);
+    if (!file.is_open()) {
+        return std::string();
+    }
+
+    std::vector<char> chunk(1 << 20);
+    uint64_t          hash = 0;
+
+    while (file) {
+        file.read(chunk.data(), chunk.size());
+        const std::streamsize readSize = file.gcount();
+        if (readSize <= 0) {
+            break;
+        }
+        hash = ArchHash64(chunk.data(), size_t(readSize), hash);
+    }
+
+    return TfStringPrintf("%016llx", (unsigned long long)hash);
+}
+
+void ImageWriter::Write(
+    const std::string&   path,
+    unsigned int         width,
+    unsigned int         height,
+    std::vector<Layer>&& layers)
+{
+    ReportErrors();
+
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _jobDone.wait(lock, [this]() { return _jobs.size() < _maxQueuedJobs; });
+
+        _jobs.push_back({ path, width, height, std::move(layers), _writeChecksums });
+    }
+    _jobAdded.notify_one();
+
+    // Without the timer a failed single frame would be reported by the next unrelated render.
+    // Batch sessions have no event loop, they flush at the end of the render instead.
+    if (!_reportTimerId && MGlobal::mayaState() == MGlobal::kInteractive) {
+        MStatus status;
+        _reportTimerId = MTimerMessage::addTimerCallback(
+            kReportTimerPeriod, ReportTimerCallback, this, &status);
+        CHECK_MSTATUS(status);
+    }
+}
+
+bool ImageWriter::Flush()
+{
+    bool succeeded;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _jobDone.wait(lock, [this]() { return _jobs.empty() && _jobsInProgress == 0; });
+        succeeded = _failedPaths.empty();
+    }
+
+    ReportErrors();
+    return succeeded;
+}
+
+void ImageWriter::ReportErrors()
+{
+    std::vector<std::string> failedPaths;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        failedPaths.swap(_failedPaths);
+    }
+
+    for (const std::string& path : failedPaths) {
+        MGlobal::displayError(MString("[hdRPR] Render image could not be saved: ") + path.c_str());
+    }
+}
+
+void ImageWriter::ReportTimerCallback(float, float, void* pClientData)
+{
+    ImageWriter* writer = static_cast<ImageWriter*>(pClientData);
+
+    bool isIdle;
+    {
+        std::lock_guard<std::mutex> lock(writer->_mutex);
+        isIdle = writer->_jobs.empty() && writer->_jobsInProgress == 0;
+    }
+
+    writer->ReportErrors();
+
+    if (isIdle) {
+        writer->RemoveReportTimer();
+    }
+}
+
+void ImageWriter::RemoveReportTimer()
+{
+    if (_reportTimerId) {
+        MTimerMessage::removeCallback(_reportTimerId);
+        _reportTimerId = 0;
+    }
+}
+
+void ImageWriter::WorkerLoop()
+{
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _jobAdded.wait(lock, [this]() { return _stop || !_jobs.empty(); });
+
+            if (_jobs.empty()) {
+                return;
+            }
+
+            job = std::move(_jobs.front());
+            _jobs.pop_front();
+            ++_jobsInProgress;
+        }
+        // Frees a place in the queue for a waiting Write call
+        _jobDone.notify_all();
+
+        bool succeeded = WriteJob(job);
+        if (succeeded && job.writeChecksum) {
+            succeeded = WriteChecksum(job.path);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            --_jobsInProgress;
+
+            if (!succeeded) {
+                _failedPaths.push_back(job.path);
+            }
+        }
+        _jobDone.notify_all();
+    }
+}
+
+bool ImageWriter::WriteJob(const Job& job)
+{
+    if (job.layers.empty()) {
+        return false;
+    }
+
+    if (job.layers.size() > 1 && IsMultiLayerFormat(job.path)) {
+        return WriteMultiLayerJob(job);
+    }
+
+    const Layer& beauty = job.layers.front();
+    if (beauty.channelNames.size() != 4) {
+        return false;
+    }
+
+    HioImageSharedPtr image = HioImage::OpenForWriting(job.path);
+    if (!image) {
+        return false;
+    }
+
+    HioImage::StorageSpec storage;
+    storage.width = job.width;
+    storage.height = job.height;
+    storage.format = HioFormatFloat32Vec4;
+    storage.flipped = true;
+    storage.data = const_cast<float*>(beauty.pixels.data());
+
+    return image->Write(storage);
+}
+
+bool ImageWriter::WriteMultiLayerJob(const Job& job)
+{
+    std::vector<std::string> channelNames;
+    std::vector<bool>        uintChannels;
+    for (const Layer& layer : job.layers) {
+        channelNames.insert(
+            channelNames.end(), layer.channelNames.begin(), layer.channelNames.end());
+        uintChannels.insert(uintChannels.end(), layer.channelNames.size(), layer.integerPixels);
+    }
+
+    ExrWriter exrWriter;
+    if (!exrWriter.Open(job.path, job.width, job.height, channelNames, uintChannels)) {
+        return false;
+    }
+
+    std::vector<float> line(size_t(job.width) * channelNames.size());
+
+    for (unsigned int y = 0; y < job.height; ++y) {
+        // exr lines go top to bottom, render buffers bottom to top
+        const size_t row = job.height - 1 - y;
+
+        size_t channelOffset = 0;
+        for (const Layer& layer : job.layers) {
+            const size_t layerChannels = layer.channelNames.size();
+            const float* layerRow = layer.pixels.data() + row * job.width * layerChannels;
+
+            // Copied as bits, integer layers must not go through float conversion
+            for (unsigned int x = 0; x < job.width; ++x) {
+                std::memcpy(
+                    &line[x * channelNames.size() + channelOffset],
+                    layerRow + x * layerChannels,
+                    layerChannels * sizeof(float));
+            }
+            channelOffset += layerChannels;
+        }
+
+        if (!exrWriter.WriteScanline(y, line.data())) {
+            return false;
+        }
+    }
+
+    return exrWriter.Close();
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,134 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef __RPRUSDIMAGEWRITER__
+#define __RPRUSDIMAGEWRITER__
+
+#include <pxr/pxr.h>
+
+#include <maya/MMessage.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/**
+ * Writes rendered frames to disk on background threads, so saving a frame
+ * doesn't block the main thread and the next frame of a sequence.
+ * Pixels are float, channel interleaved, bottom row first (as stored in Hydra render buffers).
+ */
+class ImageWriter
+{
+public:
+    struct Layer
+    {
+        std::vector<std::string> channelNames;
+        std::vector<float>       pixels;
+
+        // Pixels hold int32 bits instead of floats (primId, instanceId), written as UINT
+        bool integerPixels = false;
+    };
+
+    ImageWriter();
+    ~ImageWriter();
+
+    /** Return true if the file extension can be encoded by the writer. */
+    static bool IsSupportedFormat(const std::string& path);
+
+    /** Return true if all layers of a frame can be stored in the single file. */
+    static bool IsMultiLayerFormat(const std::string& path);
+
+    /** Return true if the file is a complete image of the given size. Checksum sidecar is
+     * verified when present, and required if requireChecksum is set. EXR header is checked if
+     * Hio can't open the file, other formats Hio can't open are valid only with a checksum.
+     */
+    static bool IsValidImage(
+        const std::string& path,
+        unsigned int       width,
+        unsigned int       height,
+        bool               requireChecksum);
+
+    /** Write the size and the hash of the file to the checksum sidecar next to it.
+     * Sidecar is written after the image is complete, so it also marks a finished frame.
+     */
+    static bool WriteChecksum(const std::string& path);
+
+    /** Write checksum sidecars for the images queued from now on. */
+    void SetWriteChecksums(bool writeChecksums) { _writeChecksums = writeChecksums; }
+
+    /** Path a partial image of a cancelled frame is kept at, so resume never takes it as the
+     * finished frame: "name.partial.ext". */
+    static std::string GetPartialImagePath(const std::string& path);
+
+    /** Queue a frame for writing. Blocks while too many frames are already waiting.
+     * The first layer is expected to be RGBA beauty, additional layers need multi-layer format.
+     */
+    void Write(
+        const std::string&   path,
+        unsigned int         width,
+        unsigned int         height,
+        std::vector<Layer>&& layers);
+
+    /** Wait until all queued frames are written. Return false if any of them failed since the
+     * errors were last reported. */
+    bool Flush();
+
+    /** Output errors collected by the worker threads to the Maya console. Main thread only. */
+    void ReportErrors();
+
+private:
+    /** Errors of queued frames are reported by the timer as soon as their jobs finish. */
+    static void ReportTimerCallback(float, float, void* pClientData);
+    void        RemoveReportTimer();
+
+    struct Job
+    {
+        std::string        path;
+        unsigned int       width;
+        unsigned int       height;
+        std::vector<Layer> layers;
+        bool               writeChecksum;
+    };
+
+    void WorkerLoop();
+    bool WriteJob(const Job& job);
+    bool WriteMultiLayerJob(const Job& job);
+
+    static std::string GetChecksumPath(const std::string& path);
+    static std::string ComputeFileHash(const std::string& path);
+
+private:
+    std::vector<std::thread> _workers;
+
+    std::mutex              _mutex;
+    std::condition_variable _jobAdded;
+    std::condition_variable _jobDone;
+
+    std::deque<Job>          _jobs;
+    size_t                   _jobsInProgress;
+    size_t                   _maxQueuedJobs;
+    bool                     _stop;
+    bool                     _writeChecksums;
+    std::vector<std::string> _failedPaths;
+
+    MCallbackId _reportTimerId = 0;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif //__RPRUSDIMAGEWRITER__
@@ -15,18 +15,24 @@
 
 #include "common.h"
 
+#include "../ViewportRender/renderSettingsCache.h"
+#include "../ViewportRender/renderSettingsSnapshot.h"
+
 #pragma warning(push, 0)
 
 #include "pxr/usd/usdRender/settings.h"
 
 #include <mayaUsd/nodes/layerManager.h>
 
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/imaging/hd/renderDelegate.h>
 #include <pxr/imaging/hd/rendererPlugin.h>
 #include <pxr/imaging/hd/rendererPluginRegistry.h>
 #include <pxr/pxr.h>
 
 #pragma warning(pop)
 
+#include <maya/MFnAttribute.h>
 #include <maya/MFnDependencyNode.h>
 #include <maya/MFnEnumAttribute.h>
 #include <maya/MFnNumericAttribute.h>
@@ -38,6 +44,7 @@
 #include <maya/MSceneMessage.h>
 #include <maya/MStatus.h>
 
+#include <algorithm>
 #include <functional>
 #include <sstream>
 
@@ -53,10 +60,24 @@ MCallbackId ProductionSettings::_openSceneCallback = 0;
 MCallbackId ProductionSettings::_importSceneCallback = 0;
 MCallbackId ProductionSettings::_beforeOpenSceneCallback = 0;
 MCallbackId ProductionSettings::_nodeAddedCallback = 0;
+MCallbackId ProductionSettings::_nodeRemovedCallback = 0;
+MCallbackId ProductionSettings::_settingsNodeCallback = 0;
 
 bool ProductionSettings::_usdCameraListRefreshed = true;
 bool ProductionSettings::_isOpeningScene = false;
 
+bool    ProductionSettings::_usdCameraCacheValid = false;
+bool    ProductionSettings::_useUsdCameraCache = false;
+UsdPrim ProductionSettings::_usdCameraPrimCache;
+
+UsdCameraIndex ProductionSettings::_usdCameraIndex;
+
+std::vector<SettingBinding>              ProductionSettings::_settingBindings;
+std::unordered_map<std::string, size_t> ProductionSettings::_settingBindingIndices;
+MObjectHandle                            ProductionSettings::_settingBindingsNode;
+HdRenderDelegate*                        ProductionSettings::_appliedRenderDelegate = nullptr;
+size_t                                   ProductionSettings::_appliedSnapshotHash = 0;
+
 std::map<std::string, HdRenderSettingDescriptorPtr> ProductionSettings::_attributeMap;
 std::vector<TabDescriptionPtr>                 ProductionSettings::_tabsLogicalStructure;
 
@@ -122,6 +143,11 @@ static MString _AlphaAttribute(const MString& attrName)
     return _MangleColorAttribute(attrName, 3);
 }
 
+static void _HashCombine(size_t& seed, size_t value)
+{
+    seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
 template <typename HydraType, typename PrefType>
 bool _RestoreValue(
     MFnDependencyNode& node,
@@ -400,48 +426,6 @@ void _CreateFloatAttribute(
         MGlobal::optionVarDoubleValue);
 }
 
-void _GetColorAttribute(
-    const MFnDependencyNode&            node,
-    const MString&                      attrName,
-    GfVec3f&                            out,
-    bool                                storeUserSetting,
-    std::function<void(GfVec3f&, bool)> alphaOp = {})
-{
-    const auto plug = node.findPlug(attrName, true);
-    if (plug.isNull()) {
-        return;
-    }
-
-    out[0] = plug.child(0).asFloat();
-    out[1] = plug.child(1).asFloat();
-    out[2] = plug.child(2).asFloat();
-    if (alphaOp) {
-        // if alphaOp is provided, it is responsible for storing the settings
-        alphaOp(out, storeUserSetting);
-    }
-}
-
-void _GetColorAttribute(
-    const MFnDependencyNode& node,
-    const MString&           attrName,
-    GfVec4f&                 out,
-    bool                     storeUserSetting)
-{
-    GfVec3f color3;
-    _GetColorAttribute(
-        node, attrName, color3, storeUserSetting, [&](GfVec3f& color3, bool storeUserSetting) {
-            const auto plugA = node.findPlug(_AlphaAttribute(attrName), true);
-            if (plugA.isNull()) {
-                TF_WARN("[rprUsd] No Alpha plug for GfVec4f");
-                return;
-            }
-            out[0] = color3[0];
-            out[1] = color3[1];
-            out[2] = color3[2];
-            out[3] = plugA.asFloat();
-        });
-}
-
 bool _IsSupportedAttribute(const VtValue& v)
 {
     return v.IsHolding<bool>() || v.IsHolding<int>() || v.IsHolding<float>()
@@ -576,27 +560,22 @@ void ProductionSettings::CreateAttributes(
     if (!rendererPlugin)
         return;
 
-    HdRenderDelegate* renderDelegate = rendererPlugin->CreateRenderDelegate();
-    if (!renderDelegate)
-        return;
-
     MObject nodeObj = GetSettingsNode();
     if (nodeObj.isNull()) {
         return;
     }
 
+    // Settings are read without creating the render delegate unless the plugin was rebuilt
+    HdRenderSettingDescriptorList rendererSettingDescriptors;
+    if (!MtohGetCachedRenderSettingDescriptors(
+            rendererPlugin, TfToken(rendererName), rendererSettingDescriptors)) {
+        return;
+    }
+
     MFnDependencyNode node(nodeObj);
     const bool        userDefaults = false;
     std::string       controlsCreationCalls;
 
-    HdRenderSettingDescriptorList rendererSettingDescriptors
-        = renderDelegate->GetRenderSettingDescriptors();
-
-    // We only needed the delegate for the settings, so release
-    rendererPlugin->DeleteRenderDelegate(renderDelegate);
-    // Null it out to make any possible usage later obv, wrong!
-    renderDelegate = nullptr;
-
     if (g_attributePrefix.GetString().empty()) {
         g_attributePrefix = TfToken(rendererName + "_Prod_");
     }
@@ -619,6 +598,105 @@ void ProductionSettings::CreateAttributes(
         "", 
         userDefaults);
 
+    // name of the proxy shape whose stage is rendered, the first one is used if empty
+    _CreateStringAttribute(
+        node, MString(g_attributePrefix.GetText()) + "Static_usdProxyShape", "", userDefaults);
+
+    // space separated list of AOVs to output in addition to color
+    _CreateStringAttribute(
+        node, MString(g_attributePrefix.GetText()) + "Static_aovs", "", userDefaults);
+
+    // seconds to keep an idle render delegate alive after production render, 0 disables it
+    _CreateIntAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_delegateIdleTimeout",
+        0,
+        userDefaults,
+        [](MFnNumericAttribute& nAttr) { nAttr.setMin(0); });
+
+    // CPU threads the renderer may use, 0 for all of them
+    _CreateIntAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_cpuThreadLimit",
+        0,
+        userDefaults,
+        [](MFnNumericAttribute& nAttr) { nAttr.setMin(0); });
+
+    // render the scene synced by the viewport render override instead of syncing a new one
+    _CreateBoolAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_reuseViewportScene",
+        false,
+        userDefaults);
+
+    // tile size of tiled rendering for images larger than device memory allows, 0 disables it
+    _CreateIntAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_tileSize",
+        0,
+        userDefaults,
+        [](MFnNumericAttribute& nAttr) { nAttr.setMin(0); });
+
+    // sequence render skips frames which already have a valid image on disk
+    _CreateBoolAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_skipExistingFrames",
+        false,
+        userDefaults);
+
+    // write checksum sidecar next to every image, used to validate frames when resuming
+    _CreateBoolAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_writeChecksums",
+        false,
+        userDefaults);
+
+    // sequence frame max samples follow the samples the previous frame needed to converge
+    _CreateBoolAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_temporalSampleBudget",
+        false,
+        userDefaults);
+
+    // samples the temporal budget never goes below or above, 0 takes adaptive min and max samples
+    _CreateIntAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_sampleBudgetMin",
+        0,
+        userDefaults,
+        [](MFnNumericAttribute& nAttr) { nAttr.setMin(0); });
+
+    _CreateIntAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_sampleBudgetMax",
+        0,
+        userDefaults,
+        [](MFnNumericAttribute& nAttr) { nAttr.setMin(0); });
+
+    // save the partial image of a cancelled render
+    _CreateBoolAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_saveCancelledFrames",
+        false,
+        userDefaults);
+
+    // shutter of Maya cameras in frames relative to the current one, camera and objects are
+    // sampled over it for motion blur
+    _CreateFloatAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_motionSampleStart",
+        0.0f,
+        userDefaults);
+    _CreateFloatAttribute(
+        node,
+        MString(g_attributePrefix.GetText()) + "Static_motionSampleEnd",
+        0.0f,
+        userDefaults);
+
+    // JSON lines file to append per-frame render statistics to
+    _CreateStringAttribute(
+        node, MString(g_attributePrefix.GetText()) + "Static_statsFile", "", userDefaults);
+
     // non production mode  attribute
     _CreateStringAttribute(
         node,
@@ -646,6 +724,8 @@ void ProductionSettings::CreateAttributes(
     }
 
     MakeAttributeLogicalStructure();
+    // Plugs of the new attributes are looked up again on the next apply
+    InvalidateSettingBindings();
 
     for (TabDescriptionPtr tabPtr : _tabsLogicalStructure) {
         std::string tabCtrlCreationCommands;
@@ -763,20 +843,105 @@ void ProductionSettings::CreateAttributes(
     }
 }
 
-void ProductionSettings::ApplySettings(HdRenderDelegate* renderDelegate)
+template <typename T> static VtValue _ReadPlug(const MPlug& plug, T value)
 {
-    HdRenderSettingDescriptorList rendererSettingDescriptors
-        = renderDelegate->GetRenderSettingDescriptors();
+    if (!plug.isNull()) {
+        _GetFromPlug<T>(plug, value);
+    }
+    return VtValue(value);
+}
 
-    MObject nodeObj = GetSettingsNode();
-    if (nodeObj.isNull()) {
-        TF_WARN("hdRPR: production render settings node was not found");
-        return;
+static GfVec3f _ReadColorPlug(const MPlug& plug, GfVec3f value)
+{
+    if (!plug.isNull()) {
+        value[0] = plug.child(0).asFloat();
+        value[1] = plug.child(1).asFloat();
+        value[2] = plug.child(2).asFloat();
     }
+    return value;
+}
 
-    MFnDependencyNode node(nodeObj);
+// Color children may be connected one by one
+static bool _IsConnected(const MPlug& plug)
+{
+    if (plug.isNull()) {
+        return false;
+    }
+
+    if (plug.isDestination()) {
+        return true;
+    }
+
+    for (unsigned int i = 0; plug.isCompound() && i < plug.numChildren(); ++i) {
+        if (plug.child(i).isDestination()) {
+            return true;
+        }
+    }
 
-    bool storeUserSetting = false;
+    return false;
+}
+
+static std::function<VtValue(const SettingBinding&)>
+_MakeSettingReader(const HdRenderSettingDescriptor& attr)
+{
+    const VtValue& defaultValue = attr.defaultValue;
+
+    if (defaultValue.IsHolding<bool>()) {
+        bool v = defaultValue.UncheckedGet<bool>();
+        return [v](const SettingBinding& binding) { return _ReadPlug(binding.plug, v); };
+    } else if (defaultValue.IsHolding<int>()) {
+        int v = defaultValue.UncheckedGet<int>();
+        return [v](const SettingBinding& binding) { return _ReadPlug(binding.plug, v); };
+    } else if (defaultValue.IsHolding<float>()) {
+        float v = defaultValue.UncheckedGet<float>();
+        return [v](const SettingBinding& binding) { return _ReadPlug(binding.plug, v); };
+    } else if (defaultValue.IsHolding<GfVec3f>()) {
+        GfVec3f v = defaultValue.UncheckedGet<GfVec3f>();
+        return [v](const SettingBinding& binding) {
+            return VtValue(_ReadColorPlug(binding.plug, v));
+        };
+    } else if (defaultValue.IsHolding<GfVec4f>()) {
+        GfVec4f v = defaultValue.UncheckedGet<GfVec4f>();
+        return [v](const SettingBinding& binding) {
+            if (binding.plug.isNull() || binding.alphaPlug.isNull()) {
+                return VtValue(v);
+            }
+            GfVec3f color = _ReadColorPlug(binding.plug, GfVec3f(v[0], v[1], v[2]));
+            return VtValue(GfVec4f(color[0], color[1], color[2], binding.alphaPlug.asFloat()));
+        };
+    } else if (defaultValue.IsHolding<TfToken>()) {
+        TfToken v = defaultValue.UncheckedGet<TfToken>();
+        return [v](const SettingBinding& binding) {
+            TfToken token = v;
+            if (!binding.plug.isNull()) {
+                _GetFromPlug(binding.plug, token);
+            }
+
+            // schema tokens contain spaces but tokens which get automatically generated does not have space inside. So remove spaces to properly apply a setting
+            std::string val = token.GetString();
+            val.erase(std::remove_if(val.begin(), val.end(), isspace), val.end());
+            return VtValue(TfToken(val));
+        };
+    } else if (defaultValue.IsHolding<SdfAssetPath>()) {
+        SdfAssetPath v = defaultValue.UncheckedGet<SdfAssetPath>();
+        return [v](const SettingBinding& binding) { return _ReadPlug(binding.plug, v); };
+    } else if (defaultValue.IsHolding<std::string>()) {
+        std::string v = defaultValue.UncheckedGet<std::string>();
+        return [v](const SettingBinding& binding) { return _ReadPlug(binding.plug, v); };
+    } else if (defaultValue.IsHolding<TfEnum>()) {
+        TfEnum v = defaultValue.UncheckedGet<TfEnum>();
+        return [v](const SettingBinding& binding) { return _ReadPlug(binding.plug, v); };
+    }
+
+    assert(!_IsSupportedAttribute(defaultValue) && "_IsSupportedAttribute out of synch");
+    return {};
+}
+
+void ProductionSettings::CompileSettingBindings(const MObject& nodeObj)
+{
+    InvalidateSettingBindings();
+
+    MFnDependencyNode node(nodeObj);
 
     for (TabDescriptionPtr tabPtr : _tabsLogicalStructure) {
         for (GroupDescriptionPtr groupPtr : tabPtr->groupVector) {
@@ -784,69 +949,121 @@ void ProductionSettings::ApplySettings(HdRenderDelegate* renderDelegate)
                 HdRenderSettingDescriptor& attr = *attrPtr->hdRenderSettingDescriptorPtr;
                 MString attrName = _MangleName(attr.key, g_attributePrefix).GetText();
 
-                bool valueGot = true;
-
-                VtValue vtValue;
-                if (attr.defaultValue.IsHolding<bool>()) {
-                    auto v = attr.defaultValue.UncheckedGet<bool>();
-                    _GetAttribute(node, attrName, v, storeUserSetting);
-                    vtValue = v;
-                } else if (attr.defaultValue.IsHolding<int>()) {
-                    auto v = attr.defaultValue.UncheckedGet<int>();
-                    _GetAttribute(node, attrName, v, storeUserSetting);
-                    vtValue = v;
-                } else if (attr.defaultValue.IsHolding<float>()) {
-                    auto v = attr.defaultValue.UncheckedGet<float>();
-                    _GetAttribute(node, attrName, v, storeUserSetting);
-                    vtValue = v;
-                } else if (attr.defaultValue.IsHolding<GfVec3f>()) {
-                    auto v = attr.defaultValue.UncheckedGet<GfVec3f>();
-                    _GetColorAttribute(node, attrName, v, storeUserSetting);
-                    vtValue = v;
-                } else if (attr.defaultValue.IsHolding<GfVec4f>()) {
-                    auto v = attr.defaultValue.UncheckedGet<GfVec4f>();
-                    _GetColorAttribute(node, attrName, v, storeUserSetting);
-                    vtValue = v;
-                } else if (attr.defaultValue.IsHolding<TfToken>()) {
-                    auto v = attr.defaultValue.UncheckedGet<TfToken>();
-                    _GetAttribute(node, attrName, v, storeUserSetting);
-
-                    // schema tokens contain spaces but tokens which get automatically generated does not have space inside. So remove spaces to properly apply a setting
-                    std::string val = v.GetString();
-                    val.erase(std::remove_if(val.begin(), val.end(), isspace), val.end());
-                    vtValue = TfToken(val);
-                } else if (attr.defaultValue.IsHolding<SdfAssetPath>()) {
-                    auto v = attr.defaultValue.UncheckedGet<SdfAssetPath>();
-                    _GetAttribute(node, attrName, v, storeUserSetting);
-                    vtValue = v;
-                } else if (attr.defaultValue.IsHolding<std::string>()) {
-                    auto v = attr.defaultValue.UncheckedGet<std::string>();
-                    _GetAttribute(node, attrName, v, storeUserSetting);
-                    vtValue = v;
-                } else if (attr.defaultValue.IsHolding<TfEnum>()) {
-                    auto v = attr.defaultValue.UncheckedGet<TfEnum>();
-                    _GetAttribute(node, attrName, v, storeUserSetting);
-                    vtValue = v;
-                } else {
-                    assert(
-                        !_IsSupportedAttribute(attr.defaultValue)
-                        && "_IsSupportedAttribute out of synch");
-
+                SettingBinding binding;
+                binding.key = attr.key;
+                binding.read = _MakeSettingReader(attr);
+                if (!binding.read) {
                     TF_WARN(
                         "hdRPR: Can't get setting: '%s' for %s", attr.key.GetText(), "HdRprPlugin");
-
-                    valueGot = false;
+                    continue;
                 }
 
-                if (valueGot) {
-                    renderDelegate->SetRenderSetting(attr.key, vtValue);
-                    // check if attribute is supported or not and display a warning if not
-                    CheckUnsupportedAttributeAndDisplayWarning(
-                        attr.key.GetText(), vtValue, nodeObj);
+                binding.plug = node.findPlug(attrName, true);
+                _settingBindingIndices[attrName.asChar()] = _settingBindings.size();
+
+                if (attr.defaultValue.IsHolding<GfVec4f>()) {
+                    MString alphaName = _AlphaAttribute(attrName);
+                    binding.alphaPlug = node.findPlug(alphaName, true);
+                    _settingBindingIndices[alphaName.asChar()] = _settingBindings.size();
                 }
+
+                _settingBindings.push_back(std::move(binding));
             }
         }
     }
+
+    _settingBindingsNode = MObjectHandle(nodeObj);
+}
+
+void ProductionSettings::InvalidateSettingBindings()
+{
+    _settingBindings.clear();
+    _settingBindingIndices.clear();
+    _settingBindingsNode = MObjectHandle();
+    _appliedRenderDelegate = nullptr;
+}
+
+void ProductionSettings::ResetAppliedSettings() { _appliedRenderDelegate = nullptr; }
+
+void ProductionSettings::ApplyOverride(
+    HdRenderDelegate* renderDelegate,
+    const TfToken&    key,
+    const VtValue&    value)
+{
+    // Changes made by others since the last ApplySettings still make it read all settings
+    const bool isInSync = renderDelegate == _appliedRenderDelegate
+        && MtohRenderSettingsSnapshot::GetHash(renderDelegate) == _appliedSnapshotHash;
+
+    MtohRenderSettingsSnapshot::Apply(renderDelegate, key, value);
+
+    if (!isInSync) {
+        return;
+    }
+
+    _appliedSnapshotHash = MtohRenderSettingsSnapshot::GetHash(renderDelegate);
+    for (SettingBinding& binding : _settingBindings) {
+        if (binding.key == key) {
+            binding.dirty = true;
+            binding.appliedValue = VtValue();
+            break;
+        }
+    }
+}
+
+size_t ProductionSettings::ApplySettings(HdRenderDelegate* renderDelegate)
+{
+    size_t settingsHash = 0;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        TF_WARN("hdRPR: production render settings node was not found");
+        return settingsHash;
+    }
+
+    if (!_settingBindingsNode.isAlive() || _settingBindingsNode.object() != nodeObj) {
+        CompileSettingBindings(nodeObj);
+    }
+
+    // Settings of another delegate, or changed by the viewport since the last call, are all
+    // read again. Values the delegate already has are not set again anyway.
+    const bool applyAll = renderDelegate != _appliedRenderDelegate
+        || MtohRenderSettingsSnapshot::GetHash(renderDelegate) != _appliedSnapshotHash;
+    _appliedRenderDelegate = renderDelegate;
+
+    MFnDependencyNode node(nodeObj);
+
+    for (SettingBinding& binding : _settingBindings) {
+        // Value of a connected plug comes from upstream nodes, which don't mark the binding dirty
+        const bool isConnected = _IsConnected(binding.plug) || _IsConnected(binding.alphaPlug);
+
+        if (applyAll || binding.dirty || isConnected) {
+            binding.dirty = false;
+
+            VtValue vtValue = binding.read(binding);
+            if (applyAll || vtValue != binding.appliedValue) {
+                MtohRenderSettingsSnapshot::Apply(renderDelegate, binding.key, vtValue);
+                // check if attribute is supported or not and display a warning if not
+                CheckUnsupportedAttributeAndDisplayWarning(binding.key.GetText(), vtValue, node);
+                binding.appliedValue = vtValue;
+            }
+        }
+
+        _HashCombine(settingsHash, binding.key.Hash());
+        _HashCombine(settingsHash, binding.appliedValue.GetHash());
+    }
+
+    // CPU thread limit goes through the Hydra render setting, 0 lets the renderer use all threads
+    int threadLimit = 0;
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_cpuThreadLimit", threadLimit, false);
+    VtValue threadLimitValue(std::max(0, threadLimit));
+    MtohRenderSettingsSnapshot::Apply(
+        renderDelegate, HdRenderSettingsTokens->threadLimit, threadLimitValue);
+    _HashCombine(settingsHash, HdRenderSettingsTokens->threadLimit.Hash());
+    _HashCombine(settingsHash, threadLimitValue.GetHash());
+
+    _appliedSnapshotHash = MtohRenderSettingsSnapshot::GetHash(renderDelegate);
+
+    return settingsHash;
 }
 
 void ProductionSettings::CheckUnsupportedAttributeAndDisplayWarning(
@@ -909,70 +1126,232 @@ void ProductionSettings::ClearUsdCameraAttributes()
     MGlobal::executeCommand("HdRpr_clearUSDCameras();");
 }
 
-void ProductionSettings::UsdCameraListRefresh()
+void ProductionSettings::UsdCameraListRefresh() { _usdCameraIndex.SetStage(GetUsdStage()); }
+
+void ProductionSettings::OnSceneCallback(void* pbCallCheckRenderGlobals)
 {
-    ClearUsdCameraAttributes();
+    if (_isOpeningScene) {
+        _isOpeningScene = false;
+    }
 
-    UsdStageRefPtr usdStageRefPtr = GetUsdStage();
+    // New scene has its own settings node
+    RegisterSettingsNodeCallback();
+    InvalidateSettingBindings();
+    InvalidateUsdCameraCache();
 
-    if (usdStageRefPtr == nullptr) {
-        return;
+    if (pbCallCheckRenderGlobals) {
+        CheckRenderGlobals();
     }
 
-    UsdPrimRange allPrims = usdStageRefPtr->TraverseAll();
+    UsdCameraListRefresh();
+}
 
-    UsdPrimRange::const_iterator it;
+bool ProductionSettings::IsUSDCameraToUse()
+{
+    if (!_usdCameraCacheValid) {
+        ResolveUsdCamera();
+    }
 
-    for (it = allPrims.begin(); it != allPrims.end(); ++it) {
-        if (it->GetTypeName() != "Camera") {
-            continue;
-        }
+    return _useUsdCameraCache;
+}
 
-        std::string usdPath = it->GetPrimPath().GetAsString();
+TfTokenVector ProductionSettings::GetAovs()
+{
+    TfTokenVector aovs;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return aovs;
+    }
 
-        MString cmd;
-        cmd.format("HdRpr_AddUsdCamera(\"^1s\")", MString(usdPath.c_str()));
-        MGlobal::executeCommand(cmd);
+    MFnDependencyNode node(nodeObj);
+    std::string       aovsString;
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_aovs", aovsString, false);
+
+    for (const std::string& aovName : TfStringTokenize(aovsString, " ,;")) {
+        aovs.push_back(TfToken(aovName));
     }
+
+    return aovs;
 }
 
-void ProductionSettings::OnSceneCallback(void* pbCallCheckRenderGlobals)
+std::string ProductionSettings::GetStatsFilePath()
 {
-    if (_isOpeningScene) {
-        _isOpeningScene = false;
+    std::string statsFilePath;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return statsFilePath;
     }
 
-    if (pbCallCheckRenderGlobals) {
-        CheckRenderGlobals();
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_statsFile", statsFilePath, false);
+
+    return statsFilePath;
+}
+
+int ProductionSettings::GetDelegateIdleTimeout()
+{
+    int idleTimeout = 0;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return idleTimeout;
     }
 
-    UsdCameraListRefresh();
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_delegateIdleTimeout", idleTimeout, false);
+
+    return std::max(0, idleTimeout);
 }
 
-bool ProductionSettings::IsUSDCameraToUse()
+bool ProductionSettings::IsViewportSceneReuseEnabled()
 {
+    bool reuseViewportScene = false;
+
     MObject nodeObj = GetSettingsNode();
     if (nodeObj.isNull()) {
-        TF_WARN("[hdRPR production] render settings node was not found");
-        return false;
+        return reuseViewportScene;
     }
 
     MFnDependencyNode node(nodeObj);
-    return node.findPlug("HdRprPlugin_Prod_Static_useUSDCamera", false).asBool();
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_reuseViewportScene", reuseViewportScene, false);
+
+    return reuseViewportScene;
+}
+
+unsigned int ProductionSettings::GetTileSize()
+{
+    int tileSize = 0;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return 0;
+    }
+
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_tileSize", tileSize, false);
+
+    return (unsigned int)std::max(0, tileSize);
+}
+
+bool ProductionSettings::IsChecksumWritingEnabled()
+{
+    bool writeChecksums = false;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return writeChecksums;
+    }
+
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_writeChecksums", writeChecksums, false);
+
+    return writeChecksums;
+}
+
+bool ProductionSettings::IsTemporalSampleBudgetEnabled()
+{
+    bool temporalSampleBudget = false;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return temporalSampleBudget;
+    }
+
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(
+        node, "HdRprPlugin_Prod_Static_temporalSampleBudget", temporalSampleBudget, false);
+
+    return temporalSampleBudget;
+}
+
+GfVec2i ProductionSettings::GetSampleBudgetRange()
+{
+    int minBudget = 0;
+    int maxBudget = 0;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return GfVec2i(minBudget, maxBudget);
+    }
+
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_sampleBudgetMin", minBudget, false);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_sampleBudgetMax", maxBudget, false);
+
+    return GfVec2i(minBudget, maxBudget);
+}
+
+bool ProductionSettings::IsCancelledFrameSavingEnabled()
+{
+    bool saveCancelledFrames = false;
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return saveCancelledFrames;
+    }
+
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_saveCancelledFrames", saveCancelledFrames, false);
+
+    return saveCancelledFrames;
+}
+
+GfVec2f ProductionSettings::GetMotionSampleInterval()
+{
+    GfVec2f interval(0.0f);
+
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        return interval;
+    }
+
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_motionSampleStart", interval[0], false);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_motionSampleEnd", interval[1], false);
+
+    return interval;
 }
 
 UsdPrim ProductionSettings::GetUsdCameraPrim()
 {
-    UsdStageRefPtr usdStage = GetUsdStage();
+    // Prim expires when the stage drops it, e.g. layer was edited or reloaded
+    if (!_usdCameraCacheValid || !_usdCameraPrimCache.IsValid()) {
+        ResolveUsdCamera();
+    }
+
+    return _usdCameraPrimCache;
+}
+
+void ProductionSettings::ResolveUsdCamera()
+{
+    _useUsdCameraCache = false;
+    _usdCameraPrimCache = UsdPrim();
+    _usdCameraCacheValid = true;
 
-    if (usdStage == nullptr) {
-        return UsdPrim();
+    MObject nodeObj = GetSettingsNode();
+    if (nodeObj.isNull()) {
+        TF_WARN("[hdRPR production] render settings node was not found");
+        return;
     }
 
-    MString path = MGlobal::executeCommandStringResult("GetCurrentUsdCamera();");
-    SdfPath sdfpath(path.asChar());
+    MFnDependencyNode node(nodeObj);
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_useUSDCamera", _useUsdCameraCache, false);
+
+    std::string cameraPath;
+    _GetAttribute(node, "HdRprPlugin_Prod_Static_usdCameraSelected", cameraPath, false);
+
+    UsdStageRefPtr usdStage = GetUsdStage();
+    if (usdStage && SdfPath::IsValidPathString(cameraPath)) {
+        _usdCameraPrimCache = usdStage->GetPrimAtPath(SdfPath(cameraPath));
+    }
+}
 
-    return usdStage->GetPrimAtPath(sdfpath);
+void ProductionSettings::InvalidateUsdCameraCache()
+{
+    _usdCameraCacheValid = false;
+    _usdCameraPrimCache = UsdPrim();
 }
 
 void ProductionSettings::attributeChangedCallback(
@@ -987,6 +1366,16 @@ void ProductionSettings::attributeChangedCallback(
 
     std::string plugName = plug.name().asChar();
 
+    // Stage of the proxy shape may be replaced by any of its inputs except the time.
+    // Camera list is kept when the stage is the same.
+    if (msg & MNodeMessage::kAttributeSet) {
+        MString attrName = MFnAttribute(plug.attribute()).name();
+        if (attrName != "time" && attrName != "outTime") {
+            InvalidateUsdCameraCache();
+            UsdCameraListRefresh();
+        }
+    }
+
     if ((plugName.find(".outTime") != std::string::npos) && (!_usdCameraListRefreshed)
         && (msg & MNodeMessage::AttributeMessage::kIncomingDirection)) {
         _usdCameraListRefreshed = true;
@@ -1005,10 +1394,77 @@ void ProductionSettings::nodeAddedCallback(MObject& node, void* pData)
     if (MayaUsd::LayerManager::supportedNodeType(depNode.typeId())) {
         MNodeMessage::addAttributeChangedCallback(node, attributeChangedCallback);
         _usdCameraListRefreshed = false;
+        InvalidateUsdCameraCache();
+    }
+}
+
+void ProductionSettings::nodeRemovedCallback(MObject& node, void* pData)
+{
+    MFnDependencyNode depNode(node);
+
+    if (MayaUsd::LayerManager::supportedNodeType(depNode.typeId())) {
+        InvalidateUsdCameraCache();
     }
 }
 
-void ProductionSettings::OnBeforeOpenCallback(void* pData) { _isOpeningScene = true; }
+void ProductionSettings::settingsAttributeChangedCallback(
+    MNodeMessage::AttributeMessage msg,
+    MPlug&                         plug,
+    MPlug&                         otherPlug,
+    void*                          clientData)
+{
+    // Value of a connected setting changes without a notification, plugs are looked up again
+    if (msg & (MNodeMessage::kConnectionMade | MNodeMessage::kConnectionBroken)) {
+        InvalidateSettingBindings();
+        return;
+    }
+
+    if (!(msg & MNodeMessage::kAttributeSet)) {
+        return;
+    }
+
+    // Color components are set through the child plugs
+    MPlug   attrPlug = plug.isChild() ? plug.parent() : plug;
+    MString attrName = MFnAttribute(attrPlug.attribute()).name();
+
+    auto bindingIt = _settingBindingIndices.find(attrName.asChar());
+    if (bindingIt != _settingBindingIndices.end()) {
+        _settingBindings[bindingIt->second].dirty = true;
+    }
+
+    if (attrName == "HdRprPlugin_Prod_Static_useUSDCamera"
+        || attrName == "HdRprPlugin_Prod_Static_usdCameraSelected") {
+        InvalidateUsdCameraCache();
+    }
+
+    if (attrName == "HdRprPlugin_Prod_Static_usdProxyShape") {
+        InvalidateActiveProxyShape();
+        InvalidateUsdCameraCache();
+        UsdCameraListRefresh();
+    }
+}
+
+void ProductionSettings::RegisterSettingsNodeCallback()
+{
+    if (_settingsNodeCallback) {
+        MMessage::removeCallback(_settingsNodeCallback);
+        _settingsNodeCallback = 0;
+    }
+
+    MObject nodeObj = GetSettingsNode();
+    if (!nodeObj.isNull()) {
+        MStatus status;
+        _settingsNodeCallback = MNodeMessage::addAttributeChangedCallback(
+            nodeObj, settingsAttributeChangedCallback, nullptr, &status);
+        CHECK_MSTATUS(status);
+    }
+}
+
+void ProductionSettings::OnBeforeOpenCallback(void* pData)
+{
+    _isOpeningScene = true;
+    InvalidateUsdCameraCache();
+}
 
 void ProductionSettings::RegisterCallbacks()
 {
@@ -1032,6 +1488,11 @@ void ProductionSettings::RegisterCallbacks()
 
     _nodeAddedCallback = MDGMessage::addNodeAddedCallback(nodeAddedCallback);
     CHECK_MSTATUS(status);
+
+    _nodeRemovedCallback = MDGMessage::addNodeRemovedCallback(nodeRemovedCallback);
+    CHECK_MSTATUS(status);
+
+    RegisterSettingsNodeCallback();
 }
 
 void ProductionSettings::UnregisterCallbacks()
@@ -1042,12 +1503,24 @@ void ProductionSettings::UnregisterCallbacks()
         MSceneMessage::removeCallback(_importSceneCallback);
         MSceneMessage::removeCallback(_beforeOpenSceneCallback);
         MSceneMessage::removeCallback(_nodeAddedCallback);
+        MSceneMessage::removeCallback(_nodeRemovedCallback);
 
         _newSceneCallback = 0;
         _openSceneCallback = 0;
         _importSceneCallback = 0;
         _beforeOpenSceneCallback = 0;
         _nodeAddedCallback = 0;
+        _nodeRemovedCallback = 0;
+
+        if (_settingsNodeCallback) {
+            MMessage::removeCallback(_settingsNodeCallback);
+            _settingsNodeCallback = 0;
+        }
+
+        InvalidateSettingBindings();
+        InvalidateUsdCameraCache();
+        _usdCameraIndex.Clear();
+        ClearProxyShapeRegistry();
     }
 }
 
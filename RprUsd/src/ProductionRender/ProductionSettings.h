@@ -14,10 +14,14 @@
 #ifndef PRODUCTION_SETTINGS_H
 #define PRODUCTION_SETTINGS_H
 
+#include "UsdCameraIndex.h"
+
 #pragma warning(push, 0)
 
 #include <mayaUsd/nodes/proxyShapeBase.h>
 
+#include <pxr/base/gf/vec2f.h>
+#include <pxr/base/gf/vec2i.h>
 #include <pxr/base/gf/vec4f.h>
 #include <pxr/base/tf/token.h>
 #include <pxr/base/vt/value.h>
@@ -31,7 +35,10 @@
 #include <maya/MMessage.h>
 #include <maya/MNodeMessage.h>
 #include <maya/MObject.h>
+#include <maya/MObjectHandle.h>
+#include <maya/MPlug.h>
 
+#include <functional>
 #include <unordered_map>
 #include <vector>
 
@@ -82,6 +89,22 @@ struct TabDescription
 
 typedef std::shared_ptr<TabDescription> TabDescriptionPtr;
 
+// Render setting compiled to the plug it is read from
+
+struct SettingBinding
+{
+    TfToken key;
+    MPlug   plug;
+    // Only GfVec4f settings have it
+    MPlug   alphaPlug;
+
+    std::function<VtValue(const SettingBinding&)> read;
+
+    // Value last pushed to the render delegate
+    VtValue appliedValue;
+    bool    dirty = true;
+};
+
 class ProductionSettings
 {
 public:
@@ -92,7 +115,15 @@ public:
     static void
                 CreateAttributes(std::map<std::string, std::string>* pMapCtrlCreationForTabs = nullptr);
     static void ClearUsdCameraAttributes();
-    static void ApplySettings(HdRenderDelegate* renderDelegate);
+    /** Return hash of all applied setting values.
+     * Only settings changed since the previous call are pushed to the same render delegate. */
+    static size_t ApplySettings(HdRenderDelegate* renderDelegate);
+    /** Push all settings on the next ApplySettings, e.g. a new delegate got an old address. */
+    static void ResetAppliedSettings();
+    /** Set a value over the artist's one for the current render only.
+     * The next ApplySettings pushes the artist's value back without reading all settings again. */
+    static void
+    ApplyOverride(HdRenderDelegate* renderDelegate, const TfToken& key, const VtValue& value);
 
     static void CheckRenderGlobals();
     static void UsdCameraListRefresh();
@@ -104,6 +135,20 @@ public:
     static UsdPrim GetUsdCameraPrim();
     static bool    IsUSDCameraToUse();
 
+    // Additional AOVs rendered together with the color, written as layers of multi-layer image
+    static TfTokenVector GetAovs();
+    static std::string   GetStatsFilePath();
+    static int           GetDelegateIdleTimeout();
+    static bool          IsViewportSceneReuseEnabled();
+    static unsigned int  GetTileSize();
+    static bool          IsChecksumWritingEnabled();
+    static bool          IsTemporalSampleBudgetEnabled();
+    // Min and max samples of the temporal budget, 0 takes the render settings
+    static GfVec2i       GetSampleBudgetRange();
+    static bool          IsCancelledFrameSavingEnabled();
+    // Shutter interval of Maya cameras in frames relative to the current one, empty if no blur
+    static GfVec2f       GetMotionSampleInterval();
+
     static void CheckUnsupportedAttributeAndDisplayWarning(
         const std::string&       attrName,
         const VtValue&           value,
@@ -116,6 +161,18 @@ private:
         MPlug&                         otherPlug,
         void*                          clientData);
     static void nodeAddedCallback(MObject& node, void* pData);
+    static void nodeRemovedCallback(MObject& node, void* pData);
+    static void settingsAttributeChangedCallback(
+        MNodeMessage::AttributeMessage msg,
+        MPlug&                         plug,
+        MPlug&                         otherPlug,
+        void*                          clientData);
+
+    static void RegisterSettingsNodeCallback();
+    static void CompileSettingBindings(const MObject& nodeObj);
+    static void InvalidateSettingBindings();
+    static void InvalidateUsdCameraCache();
+    static void ResolveUsdCamera();
 
     static void OnBeforeOpenCallback(void*);
 
@@ -130,10 +187,26 @@ private:
 
     static MCallbackId _beforeOpenSceneCallback;
     static MCallbackId _nodeAddedCallback;
+    static MCallbackId _nodeRemovedCallback;
+    static MCallbackId _settingsNodeCallback;
 
     static bool _usdCameraListRefreshed;
     static bool _isOpeningScene;
 
+    static UsdCameraIndex _usdCameraIndex;
+
+    // Usd camera resolved for the last render, dropped by scene, proxy shape and setting changes
+    static bool    _usdCameraCacheValid;
+    static bool    _useUsdCameraCache;
+    static UsdPrim _usdCameraPrimCache;
+
+    // Compiled once per settings node, values are re-read only for the dirty bindings
+    static std::vector<SettingBinding>              _settingBindings;
+    static std::unordered_map<std::string, size_t> _settingBindingIndices;
+    static MObjectHandle                            _settingBindingsNode;
+    static HdRenderDelegate*                        _appliedRenderDelegate;
+    static size_t                                   _appliedSnapshotHash;
+
     static std::map<std::string, HdRenderSettingDescriptorPtr> _attributeMap;
     static std::vector<TabDescriptionPtr>                 _tabsLogicalStructure;
 };
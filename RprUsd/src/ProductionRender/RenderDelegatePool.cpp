@@ -0,0 +1,162 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "RenderDelegatePool.h"
+
+#include "../ViewportRender/renderSettingsSnapshot.h"
+
+#include <maya/MTimerMessage.h>
+
+#pragma warning(push, 0)
+
+#include <pxr/imaging/hd/renderDelegate.h>
+#include <pxr/imaging/hd/renderIndex.h>
+#include <pxr/imaging/hd/rendererPlugin.h>
+#include <pxr/imaging/hd/rendererPluginRegistry.h>
+
+#pragma warning(pop)
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// Parked index is checked for expiration with this period, in seconds
+static const float kEvictionCheckPeriod = 5.0f;
+
+RenderDelegatePool::~RenderDelegatePool() { Clear(); }
+
+HdRenderIndex* RenderDelegatePool::Acquire(
+    const TfToken&        rendererName,
+    const HdDriverVector& drivers,
+    HdRendererPlugin**    outPlugin)
+{
+    if (_renderIndex && _rendererName == rendererName) {
+        HdRenderIndex* renderIndex = _renderIndex;
+        *outPlugin = _plugin;
+
+        _renderIndex = nullptr;
+        _plugin = nullptr;
+        Clear();
+
+        // Delegate was stopped when the previous render finished
+        renderIndex->GetRenderDelegate()->Restart();
+        return renderIndex;
+    }
+
+    Clear();
+
+    *outPlugin = HdRendererPluginRegistry::GetInstance().GetRendererPlugin(rendererName);
+    if (!*outPlugin) {
+        return nullptr;
+    }
+
+    HdRenderDelegate* renderDelegate = (*outPlugin)->CreateRenderDelegate();
+    HdRenderIndex*    renderIndex
+        = renderDelegate ? HdRenderIndex::New(renderDelegate, drivers) : nullptr;
+    if (!renderIndex) {
+        if (renderDelegate) {
+            (*outPlugin)->DeleteRenderDelegate(renderDelegate);
+        }
+        HdRendererPluginRegistry::GetInstance().ReleasePlugin(*outPlugin);
+        *outPlugin = nullptr;
+    }
+
+    return renderIndex;
+}
+
+void RenderDelegatePool::Release(
+    HdRendererPlugin* plugin,
+    HdRenderIndex*    renderIndex,
+    int               idleTimeout)
+{
+    Clear();
+
+    // Prims left by a scene delegate would show up in the next render
+    if (idleTimeout <= 0 || !plugin || !renderIndex || !IsEmpty(renderIndex)) {
+        Destroy(plugin, renderIndex);
+        return;
+    }
+
+    _rendererName = TfToken(plugin->GetPluginId());
+    _plugin = plugin;
+    _renderIndex = renderIndex;
+    _evictionTime = std::chrono::steady_clock::now() + std::chrono::seconds(idleTimeout);
+
+    MStatus status;
+    _evictionTimerId
+        = MTimerMessage::addTimerCallback(kEvictionCheckPeriod, OnEvictionTimer, this, &status);
+}
+
+void RenderDelegatePool::Clear()
+{
+    if (_evictionTimerId) {
+        MTimerMessage::removeCallback(_evictionTimerId);
+        _evictionTimerId = 0;
+    }
+
+    Destroy(_plugin, _renderIndex);
+
+    _plugin = nullptr;
+    _renderIndex = nullptr;
+    _rendererName = TfToken();
+}
+
+void RenderDelegatePool::OnEvictionTimer(float, float, void* pClientData)
+{
+    RenderDelegatePool* pool = static_cast<RenderDelegatePool*>(pClientData);
+
+    if (std::chrono::steady_clock::now() >= pool->_evictionTime) {
+        pool->Clear();
+    }
+}
+
+bool RenderDelegatePool::IsEmpty(HdRenderIndex* renderIndex)
+{
+    if (!renderIndex->GetRprimIds().empty()) {
+        return false;
+    }
+
+    HdRenderDelegate* renderDelegate = renderIndex->GetRenderDelegate();
+    const SdfPath&    root = SdfPath::AbsoluteRootPath();
+
+    for (const TfToken& typeId : renderDelegate->GetSupportedSprimTypes()) {
+        if (!renderIndex->GetSprimSubtree(typeId, root).empty()) {
+            return false;
+        }
+    }
+
+    for (const TfToken& typeId : renderDelegate->GetSupportedBprimTypes()) {
+        if (!renderIndex->GetBprimSubtree(typeId, root).empty()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RenderDelegatePool::Destroy(HdRendererPlugin* plugin, HdRenderIndex* renderIndex)
+{
+    if (plugin == nullptr) {
+        return;
+    }
+
+    if (renderIndex != nullptr) {
+        // Index is deleted first, its prims may still reference the delegate
+        HdRenderDelegate* renderDelegate = renderIndex->GetRenderDelegate();
+        delete renderIndex;
+
+        MtohRenderSettingsSnapshot::Forget(renderDelegate);
+        plugin->DeleteRenderDelegate(renderDelegate);
+    }
+    HdRendererPluginRegistry::GetInstance().ReleasePlugin(plugin);
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,79 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef __RPRUSDRENDERDELEGATEPOOL__
+#define __RPRUSDRENDERDELEGATEPOOL__
+
+#include <maya/MMessage.h>
+
+#pragma warning(push, 0)
+
+#include <pxr/base/tf/token.h>
+#include <pxr/imaging/hd/driver.h>
+#include <pxr/pxr.h>
+
+#pragma warning(pop)
+
+#include <chrono>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+class HdRendererPlugin;
+class HdRenderIndex;
+
+/**
+ * Keeps an idle render delegate alive between production renders.
+ * Creating hdRPR delegate sets up the renderer context and compiles kernels, which takes seconds,
+ * so an idle delegate is parked here and handed out to the next render.
+ * Delegate is parked together with its render index: hdRPR keeps per-index state (render param,
+ * render buffers), so it's never attached to another index. Only an index emptied of all prims
+ * is parked, the next render populates it from scratch.
+ * Parked index is released after the idle timeout.
+ */
+class RenderDelegatePool
+{
+public:
+    RenderDelegatePool() = default;
+    ~RenderDelegatePool();
+
+    /** Return the parked render index of the renderer or create a new one with a new delegate. */
+    HdRenderIndex* Acquire(
+        const TfToken&        rendererName,
+        const HdDriverVector& drivers,
+        HdRendererPlugin**    outPlugin);
+
+    /** Park the index for idleTimeout seconds, release it right away if timeout is 0 or the index
+     * still has prims. Previously parked index is released. */
+    void Release(HdRendererPlugin* plugin, HdRenderIndex* renderIndex, int idleTimeout);
+
+    /** Release the parked index and delegate. */
+    void Clear();
+
+private:
+    static void OnEvictionTimer(float, float, void* pClientData);
+
+    static bool IsEmpty(HdRenderIndex* renderIndex);
+    static void Destroy(HdRendererPlugin* plugin, HdRenderIndex* renderIndex);
+
+private:
+    TfToken           _rendererName;
+    HdRendererPlugin* _plugin = nullptr;
+    HdRenderIndex*    _renderIndex = nullptr;
+
+    std::chrono::steady_clock::time_point _evictionTime;
+    MCallbackId                           _evictionTimerId = 0;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif //__RPRUSDRENDERDELEGATEPOOL__
@@ -193,13 +193,8 @@ void RenderProgressBars::close()
 // -----------------------------------------------------------------------------
 bool RenderProgressBars::isCancelled()
 {
-    // For MacOS one second interval is too big for proper checking of cancellation status. Let's do
-    // it 0.1 sec
-#if defined(OSMac_)
-    clock_t interval = CLOCKS_PER_SEC / 10;
-#else
-    clock_t interval = CLOCKS_PER_SEC;
-#endif
+    // Query is cheap, check often enough to keep cancel latency well below 0.1 sec
+    clock_t interval = CLOCKS_PER_SEC / 20;
     clock_t t = clock();
 
     if (m_lastCanceledCheck + interval <= t) {
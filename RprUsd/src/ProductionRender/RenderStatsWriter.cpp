@@ -0,0 +1,99 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "RenderStatsWriter.h"
+
+#pragma warning(push, 0)
+
+#include <pxr/base/js/json.h>
+#include <pxr/base/tf/stringUtils.h>
+
+#pragma warning(pop)
+
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <windows.h>
+// windows.h must go first
+#include <psapi.h>
+#endif
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+void WriteOptional(JsWriter& writer, const char* key, int64_t value)
+{
+    writer.WriteKey(key);
+    if (value < 0) {
+        writer.WriteValue(nullptr);
+    } else {
+        writer.WriteValue(value);
+    }
+}
+
+} // namespace
+
+bool RenderStatsWriter::Append(const std::string& path, const FrameRenderStats& stats)
+{
+    // Build the whole line first, so an interrupted render doesn't leave half of an object
+    std::ostringstream line;
+    {
+        JsWriter writer(line, JsWriter::Style::Compact);
+
+        writer.BeginObject();
+        writer.WriteKeyValue("frame", stats.frame);
+        writer.WriteKeyValue("camera", stats.camera);
+        WriteOptional(writer, "syncTimeMs", stats.syncTimeMs);
+        WriteOptional(writer, "firstIterationTimeMs", stats.firstIterationTimeMs);
+        WriteOptional(writer, "timeToConvergeMs", stats.timeToConvergeMs);
+        WriteOptional(writer, "totalTimeMs", stats.totalTimeMs);
+        WriteOptional(writer, "samples", stats.samples);
+        writer.WriteKeyValue("peakMemoryBytes", stats.peakMemoryBytes);
+        writer.WriteKeyValue("memoryDeltaBytes", stats.memoryDeltaBytes);
+        // Hex string, 64 bit values don't survive JSON parsers which use doubles
+        writer.WriteKeyValue(
+            "settingsHash", TfStringPrintf("%016llx", (unsigned long long)stats.settingsHash));
+        writer.WriteKeyValue("converged", stats.converged);
+        writer.WriteKeyValue("cancelled", stats.cancelled);
+        writer.EndObject();
+    }
+    line << '\n';
+
+    std::ofstream file(path, std::ios::out | std::ios::app);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << line.str();
+    return file.good();
+}
+
+uint64_t RenderStatsWriter::GetMemoryUsage()
+{
+#ifdef _WIN32
+    // Lifetime peak of the process never goes down, so the frame peak is sampled by the caller
+    PROCESS_MEMORY_COUNTERS_EX counters;
+    if (GetProcessMemoryInfo(
+            GetCurrentProcess(),
+            reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&counters),
+            sizeof(counters))) {
+        return counters.PrivateUsage;
+    }
+#endif
+
+    return 0;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
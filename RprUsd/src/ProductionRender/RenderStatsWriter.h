@@ -0,0 +1,63 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef __RPRUSDRENDERSTATSWRITER__
+#define __RPRUSDRENDERSTATSWRITER__
+
+#include <pxr/pxr.h>
+
+#include <cstdint>
+#include <string>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/**
+ * Statistics of a single rendered frame. Negative values mean the value is not known.
+ */
+struct FrameRenderStats
+{
+    double      frame = 0.0;
+    std::string camera;
+
+    int64_t syncTimeMs = -1;
+    int64_t firstIterationTimeMs = -1;
+    int64_t timeToConvergeMs = -1;
+    int64_t totalTimeMs = -1;
+
+    // Private memory of the Maya process sampled while the frame renders, hdRPR doesn't report
+    // device memory in its render stats. Delta is from the frame start to the frame end.
+    int64_t  samples = -1;
+    uint64_t peakMemoryBytes = 0;
+    int64_t  memoryDeltaBytes = 0;
+    uint64_t settingsHash = 0;
+
+    bool converged = false;
+    bool cancelled = false;
+};
+
+/**
+ * Appends frame statistics to a JSON-lines file, one object per line,
+ * so render cost could be tracked by pipeline tools.
+ */
+class RenderStatsWriter
+{
+public:
+    static bool Append(const std::string& path, const FrameRenderStats& stats);
+
+    /** Current private memory of the Maya process, 0 if not available. */
+    static uint64_t GetMemoryUsage();
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif //__RPRUSDRENDERSTATSWRITER__
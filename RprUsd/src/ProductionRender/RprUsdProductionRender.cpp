@@ -13,21 +13,29 @@
 
 #include "RprUsdProductionRender.h"
 
+#include "ExrWriter.h"
 #include "ProductionSettings.h"
+#include "RenderStatsWriter.h"
 #include "common.h"
 
+#include "../ViewportRender/renderOverride.h"
+#include "../ViewportRender/renderSettingsSnapshot.h"
+
 // For getting versions of RPR SDK and RIF SDK
 #include "RadeonProRenderUSD/deps/RIF/include/RadeonImageFilters_version.h"
 #include "RadeonProRenderUSD/deps/RPR/RadeonProRender/inc/RadeonProRender.h"
 
+#include <maya/MAnimControl.h>
 #include <maya/MCommonRenderSettingsData.h>
 #include <maya/MDagPath.h>
 #include <maya/MDistance.h>
+#include <maya/MFnAttribute.h>
 #include <maya/MFnCamera.h>
 #include <maya/MFnRenderLayer.h>
 #include <maya/MFnTransform.h>
 #include <maya/MGlobal.h>
 #include <maya/MRenderView.h>
+#include <maya/MSceneMessage.h>
 #include <maya/MTimerMessage.h>
 
 #pragma warning(push, 0)
@@ -37,9 +45,11 @@
 #include <hdMaya/delegates/sceneDelegate.h>
 #include <hdMaya/utils.h>
 
+#include <pxr/base/gf/half.h>
 #include <pxr/base/gf/matrix4d.h>
 #include <pxr/base/tf/debug.h>
 #include <pxr/base/tf/instantiateSingleton.h>
+#include <pxr/base/tf/staticTokens.h>
 #include <pxr/base/vt/value.h>
 #include <pxr/imaging/glf/contextCaps.h>
 #include <pxr/imaging/hd/camera.h>
@@ -55,25 +65,84 @@
 #include <pxr/usd/usdGeom/camera.h>
 #pragma warning(pop)
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 #include <thread>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
 TfToken RprUsdProductionRender::_rendererName;
 
+// Convergence is polled often, so a frame finishes right after the delegate converges.
+// Render View refresh is much more expensive, its interval adapts to the measured refresh cost.
+static const float         kConvergencePollInterval = 0.02f;
+static const unsigned long kMinPreviewRefreshIntervalMs = 100;
+static const unsigned long kMaxPreviewRefreshIntervalMs = 1000;
+
+// Converged state right after a restart is trusted anyway if the progress never changes
+static const unsigned long kRestartTimeoutMs = 5000;
+
+TF_DEFINE_PRIVATE_TOKENS(_tokens, ((denoisingEnable, "rpr:denoising:enable")));
+
+struct RprUsdProductionRender::TiledRender
+{
+    std::string  path;
+    unsigned int tileSize = 0;
+    unsigned int tilesX = 0;
+    unsigned int tilesY = 0;
+
+    // Tile being rendered, without the overlap
+    unsigned int tile = 0;
+    unsigned int tileX0 = 0;
+    unsigned int bandY0 = 0;
+    unsigned int tileWidth = 0;
+    unsigned int bandHeight = 0;
+
+    // Only one band of tiles is kept in memory, it's written to the file once all its tiles
+    // are done. Channels of all AOVs are interleaved the same way as in EXR scanline.
+    ExrWriter                exrWriter;
+    std::vector<std::string> channelNames;
+    std::vector<bool>        uintChannels;
+    std::vector<float>       band;
+
+    bool failed = false;
+};
+
 RprUsdProductionRender::RprUsdProductionRender()
     : _renderIsStarted(false)
     , _initialized(false)
     , _hasDefaultLighting(false)
     , _isConverged(false)
     , _isCancelled(false)
+    , _isSequenceMode(false)
+    , _isHeadless(false)
+    , _lastReportedProgress(-1)
+    , _previewRefreshIntervalMs(kMinPreviewRefreshIntervalMs)
+    , _renderRegion(0, 0, 0, 0)
     , _hgi(Hgi::CreatePlatformDefaultHgi())
     , _hgiDriver { HgiTokens->renderDriver, VtValue(_hgi.get()) }
     , _additionalStatsWasOutput(false)
 {
+    // Scene kept synced by an unfinished sequence belongs to the old scene
+    _beforeNewSceneCallbackId = MSceneMessage::addCallback(
+        MSceneMessage::kBeforeNew, SceneChangedCallback, this);
+    _beforeOpenSceneCallbackId = MSceneMessage::addCallback(
+        MSceneMessage::kBeforeOpen, SceneChangedCallback, this);
 }
 
-RprUsdProductionRender::~RprUsdProductionRender() { ClearHydraResources(); }
+RprUsdProductionRender::~RprUsdProductionRender()
+{
+    MSceneMessage::removeCallback(_beforeNewSceneCallbackId);
+    MSceneMessage::removeCallback(_beforeOpenSceneCallbackId);
+
+    StopIpr();
+    ClearHydraResources();
+    _delegatePool.Clear();
+
+    // finish writing of queued images
+    _imageWriter.reset();
+}
 
 // -----------------------------------------------------------------------------
 
@@ -140,6 +209,17 @@ MStatus restoreRenderLayer(const MString& oldLayerName, const MString& newLayerN
     return MS::kSuccess;
 }
 
+void RprUsdProductionRender::SceneChangedCallback(void* pClientData)
+{
+    RprUsdProductionRender* pProductionRender = static_cast<RprUsdProductionRender*>(pClientData);
+
+    pProductionRender->StopIpr();
+    if (pProductionRender->_isSequenceMode) {
+        pProductionRender->EndSequence();
+    }
+    pProductionRender->ReleaseLastFrame();
+}
+
 void RprUsdProductionRender::RPRMainThreadTimerEventCallback(float, float, void* pClientData)
 {
     RprUsdProductionRender* pProductionRender = static_cast<RprUsdProductionRender*>(pClientData);
@@ -149,6 +229,38 @@ void RprUsdProductionRender::RPRMainThreadTimerEventCallback(float, float, void*
 }
 
 bool RprUsdProductionRender::ProcessTimerMessage()
+{
+    SampleMemoryUsage();
+
+    if (_isTiledRender) {
+        return ProcessTile();
+    }
+
+    if (_isIprMode) {
+        if (_isIprPaused) {
+            return true;
+        }
+
+        CheckIprChanges();
+
+        // Converged image stays in Render View until something changes
+        if (_isConverged) {
+            return true;
+        }
+    }
+
+    const bool refreshPreview
+        = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), _lastPreviewRefreshTime)
+        >= _previewRefreshIntervalMs;
+
+    if (refreshPreview) {
+        UpdateProgress();
+    }
+
+    return RefreshAndCheck(refreshPreview);
+}
+
+void RprUsdProductionRender::UpdateProgress()
 {
     HdRenderDelegate* renderDelegate = _renderIndex->GetRenderDelegate();
 
@@ -157,7 +269,13 @@ bool RprUsdProductionRender::ProcessTimerMessage()
     VtDictionary dict = renderDelegate->GetRenderStats();
     double       percentDone = dict.find("percentDone")->second.Get<double>();
 
-    _renderProgressBars->update((int)percentDone);
+    if (_renderProgressBars) {
+        _renderProgressBars->update((int)percentDone);
+    } else if (_isHeadless && (int)percentDone / 10 != _lastReportedProgress / 10) {
+        _lastReportedProgress = (int)percentDone;
+        OutputInfoToMayaConsoleCommon(
+            MString("Progress: ") + std::to_string(_lastReportedProgress).c_str() + "%");
+    }
 
     if (!_additionalStatsWasOutput) {
         float firstIterationTime = dict.find("firstIterationRenderTime")->second.Get<float>();
@@ -165,23 +283,80 @@ bool RprUsdProductionRender::ProcessTimerMessage()
         if (firstIterationTime > 0.0f) {
             OutputInfoToMayaConsole("First Iteration Time: ", (unsigned long)firstIterationTime);
 
+            _firstIterationTimeMs = (int64_t)firstIterationTime;
             _additionalStatsWasOutput = true;
         }
     }
-
-    return RefreshAndCheck();
 }
 
-bool RprUsdProductionRender::RefreshAndCheck()
+bool RprUsdProductionRender::RefreshAndCheck(bool refreshPreview)
 {
-    RefreshRenderView();
+    // Checked before the preview refresh, so a large image refresh doesn't delay the abort
+    _isCancelled = _renderProgressBars && _renderProgressBars->isCancelled();
+    if (_isCancelled) {
+        _isConverged = false;
+        StopRender();
+        return false;
+    }
+
+    if (refreshPreview) {
+        TimePoint refreshStartTime = GetCurrentChronoTime();
+
+        if (!_isHeadless) {
+            RefreshRenderView();
+
+            // Cancel requested while the band was pushed doesn't wait for the next poll
+            _isCancelled = _renderProgressBars && _renderProgressBars->isCancelled();
+            if (_isCancelled) {
+                _isConverged = false;
+                StopRender();
+                return false;
+            }
+        }
+
+        // Keep preview refresh within ~10% of the main thread time
+        _lastPreviewRefreshTime = GetCurrentChronoTime();
+        unsigned long refreshMiliseconds = TimeDiffChrono<std::chrono::milliseconds>(
+            _lastPreviewRefreshTime, refreshStartTime);
+        _previewRefreshIntervalMs = std::min(
+            kMaxPreviewRefreshIntervalMs,
+            std::max(kMinPreviewRefreshIntervalMs, refreshMiliseconds * 10));
+    }
 
     HdRenderBuffer* bufferPtr = _taskController->GetRenderOutput(HdAovTokens->color);
     assert(bufferPtr);
 
-    _isCancelled = _renderProgressBars && _renderProgressBars->isCancelled();
+    if (IsRenderConverged(bufferPtr)) {
+        _isConverged = true;
+
+        if (_isIprMode) {
+            // Keep the scene synced, renderer is restarted by the next change
+            RefreshRenderView(true);
+            _GetRenderDelegate()->Stop();
+            return true;
+        }
+
+        if (_isSampleBudgetApplied && !_sampleBudget->ReachedThreshold(GetCompletedSamples())) {
+            HdRenderDelegate* renderDelegate = _GetRenderDelegate();
+
+            // Frame used up its budget before the noise threshold, render it again with more
+            if (_sampleBudget->Raise(renderDelegate)) {
+                OutputInfoToMayaConsoleCommon(
+                    MString("Noise threshold not reached, sample budget raised to ")
+                    + std::to_string(_sampleBudget->GetBudget()).c_str());
+
+                _isConverged = false;
+                renderDelegate->Restart();
+                MarkRestarted();
+                Render(false);
+                return true;
+            }
+
+            OutputWarningToMayaConsoleCommon(
+                "Noise threshold not reached within the max sample budget, frame is not converged");
+            _isConverged = false;
+        }
 
-    if (bufferPtr->IsConverged() || _isCancelled) {
         StopRender();
         return false;
     }
@@ -189,6 +364,127 @@ bool RprUsdProductionRender::RefreshAndCheck()
     return true;
 }
 
+MStatus
+RprUsdProductionRender::StartIpr(unsigned int width, unsigned int height, MDagPath cameraPath)
+{
+    StopIpr();
+
+    if (_isSequenceMode) {
+        MGlobal::displayError("[hdRPR] IPR can't be started during sequence render");
+        return MStatus::kFailure;
+    }
+
+    ReleaseLastFrame();
+
+    _isIprMode = true;
+    _isIprPaused = false;
+    _isHeadless = false;
+    _skipExisting = false;
+    _renderRegion = GfVec4i(0, 0, 0, 0);
+
+    MStatus status = StartRender(width, height, "", cameraPath, false);
+    if (status != MStatus::kSuccess) {
+        _isIprMode = false;
+        return status;
+    }
+
+    // Render settings are not tracked by Hydra, listen to the settings node
+    MObject settingsNode = GetSettingsNode();
+    if (!settingsNode.isNull()) {
+        _iprSettingsCallbackId = MNodeMessage::addAttributeChangedCallback(
+            settingsNode, IprSettingsChangedCallback, this, &status);
+    }
+    _iprSettingsDirty = false;
+
+    return MStatus::kSuccess;
+}
+
+void RprUsdProductionRender::StopIpr()
+{
+    if (!_isIprMode) {
+        return;
+    }
+
+    if (_iprSettingsCallbackId) {
+        MMessage::removeCallback(_iprSettingsCallbackId);
+        _iprSettingsCallbackId = 0;
+    }
+
+    StopRender();
+    _isIprMode = false;
+    _isIprPaused = false;
+}
+
+void RprUsdProductionRender::PauseIpr(bool pause)
+{
+    if (!_isIprMode || !_renderIsStarted || pause == _isIprPaused) {
+        return;
+    }
+
+    _isIprPaused = pause;
+
+    HdRenderDelegate* renderDelegate = _GetRenderDelegate();
+    if (pause) {
+        renderDelegate->Stop();
+    } else if (!_isConverged) {
+        renderDelegate->Restart();
+    }
+}
+
+void RprUsdProductionRender::IprSettingsChangedCallback(
+    MNodeMessage::AttributeMessage msg,
+    MPlug&                         plug,
+    MPlug&,
+    void* pClientData)
+{
+    if (!(msg & MNodeMessage::kAttributeSet)) {
+        return;
+    }
+
+    if (MFnAttribute(plug.attribute()).name().indexW("HdRprPlugin_Prod_") == 0) {
+        static_cast<RprUsdProductionRender*>(pClientData)->_iprSettingsDirty = true;
+    }
+}
+
+void RprUsdProductionRender::CheckIprChanges()
+{
+    // Usd stage changes are queued by the imaging delegate until applied
+    if (_pImagingDelegate) {
+        _pImagingDelegate->ApplyPendingUpdates();
+    }
+
+    // Maya changes are marked in the change tracker right away by hdMaya adapter callbacks
+    const unsigned int sceneStateVersion
+        = _renderIndex->GetChangeTracker().GetSceneStateVersion();
+
+    GfMatrix4d viewMatrix;
+    GfMatrix4d projectionMatrix;
+    ComputeCameraMatrices(viewMatrix, projectionMatrix);
+
+    const bool cameraChanged
+        = viewMatrix != _lastViewMatrix || projectionMatrix != _lastProjectionMatrix;
+
+    if (sceneStateVersion == _lastSceneStateVersion && !cameraChanged && !_iprSettingsDirty) {
+        return;
+    }
+
+    if (_iprSettingsDirty) {
+        _iprSettingsDirty = false;
+        ApplySettings();
+    }
+
+    if (_isConverged) {
+        _GetRenderDelegate()->Restart();
+        _isConverged = false;
+    }
+
+    // Buffer may still report the converged image rendered before the change
+    MarkRestarted();
+
+    // Only dirty prims are synced, the renderer restarts progressive sampling by itself
+    Render(false);
+}
+
 MStatus RprUsdProductionRender::StartRender(
     unsigned int width,
     unsigned int height,
@@ -198,37 +494,124 @@ MStatus RprUsdProductionRender::StartRender(
 {
     StopRender();
 
+    // Only sequences flush their images, a single render would keep the paths forever
+    if (!_isSequenceMode) {
+        _unflushedImagePaths.clear();
+    }
+
     _ID = SdfPath("/HdMayaViewportRenderer")
               .AppendChild(TfToken(TfStringPrintf("_HdMaya_%s_%p", _rendererName.GetText(), this)));
 
-    _viewport = GfVec4d(0, 0, width, height);
+    _imageWidth = width;
+    _imageHeight = height;
+
+    // Region is rendered to buffers of the region size with the cropped projection
+    if (HasRenderRegion()) {
+        _viewport = GfVec4d(0, 0, _renderRegion[2], _renderRegion[3]);
+    } else {
+        _viewport = GfVec4d(0, 0, width, height);
+    }
 
     _newLayerName = newLayerName;
     _camPath = cameraPath;
     _renderIsStarted = true;
     switchRenderLayer(_oldLayerName, _newLayerName);
 
+    // Region render updates an existing image, it is never skipped
+    if (_skipExisting && !HasRenderRegion()) {
+        MString imagePath = GetImagePath();
+        if (ImageWriter::IsValidImage(
+                imagePath.asChar(),
+                width,
+                height,
+                ProductionSettings::IsChecksumWritingEnabled())) {
+            OutputInfoToMayaConsoleCommon("Frame skipped, valid image exists: " + imagePath);
+            _unflushedImagePaths.append(imagePath);
+
+            restoreRenderLayer(_oldLayerName, _newLayerName);
+            _renderIsStarted = false;
+            _isCancelled = false;
+            return MStatus::kSuccess;
+        }
+    }
+
     _startRenderTime = GetCurrentChronoTime();
+    _frameStartMemoryBytes = RenderStatsWriter::GetMemoryUsage();
+    _framePeakMemoryBytes = _frameStartMemoryBytes;
+
+    if (_isSequenceMode && _initialized) {
+        // Keep the synced scene from the previous frame, only advance the time.
+        // Prims changed by the time switch are already marked dirty in the change tracker.
+        UpdateHydraResourcesTime();
+
+        // Color buffer still reports the previous frame as converged
+        MarkRestarted();
+    } else if (!InitSharedHydraResources() && !InitHydraResources()) {
+        MGlobal::displayError("[hdRPR] Render delegate could not be initialized");
 
-    if (!InitHydraResources()) {
+        restoreRenderLayer(_oldLayerName, _newLayerName);
+        _renderIsStarted = false;
         return MStatus::kFailure;
     }
 
-    MRenderView::startRender(width, height, false, true);
+    _isConverged = false;
+    _isCancelled = false;
+    _firstIterationTimeMs = -1;
+
+    const unsigned int tileSize = ProductionSettings::GetTileSize();
+    if (tileSize > 0 && !_isIprMode && !HasRenderRegion()
+        && (width > tileSize || height > tileSize)) {
+        _isTiledRender = true;
+        if (!BeginTiledRender(tileSize)) {
+            StopRender();
+            return MStatus::kSuccess;
+        }
 
-    _renderProgressBars = std::make_unique<RenderProgressBars>(false);
+        // there is no event loop to drive the timer callback in batch mode
+        synchronousRender = synchronousRender || _isHeadless;
+    } else if (!_isHeadless) {
+        if (HasRenderRegion()) {
+            // keep the previous image around the region
+            MRenderView::startRegionRender(
+                width,
+                height,
+                _renderRegion[0],
+                _renderRegion[0] + _renderRegion[2] - 1,
+                _renderRegion[1],
+                _renderRegion[1] + _renderRegion[3] - 1,
+                true,
+                true);
+        } else {
+            MRenderView::startRender(width, height, false, true);
+        }
+        _renderViewSamples = -1;
+        _renderViewNextRow = 0;
 
-    ApplySettings();
-    Render();
+        // IPR runs until stopped from Render View, there is no progress to show
+        if (!_isIprMode) {
+            _renderProgressBars = std::make_unique<RenderProgressBars>(false);
+        }
+    } else {
+        // there is no event loop to drive the timer callback in batch mode
+        synchronousRender = true;
+        _lastReportedProgress = -1;
+    }
 
-    const float REFRESH_RATE = 1.0f;
+    if (!_isTiledRender) {
+        ApplySettings();
+        Render();
+        SampleMemoryUsage();
+    }
+
+    _lastPreviewRefreshTime = GetCurrentChronoTime();
+    _previewRefreshIntervalMs = kMinPreviewRefreshIntervalMs;
 
     if (!synchronousRender) {
         MStatus status;
         _callbackTimerId = MTimerMessage::addTimerCallback(
-            REFRESH_RATE, RPRMainThreadTimerEventCallback, this, &status);
+            kConvergencePollInterval, RPRMainThreadTimerEventCallback, this, &status);
     } else {
-        ProcessSyncRender(REFRESH_RATE);
+        ProcessSyncRender(kConvergencePollInterval);
     }
 
     return MStatus::kSuccess;
@@ -242,9 +625,83 @@ void RprUsdProductionRender::ProcessSyncRender(float refreshRate)
     } while (ProcessTimerMessage());
 }
 
+void RprUsdProductionRender::BeginSequence()
+{
+    StopIpr();
+    StopRender();
+    ClearHydraResources();
+    ReleaseLastFrame();
+    _unflushedImagePaths.clear();
+    _sampleBudgets.clear();
+    _sampleBudget = nullptr;
+
+    _isSequenceMode = true;
+}
+
+void RprUsdProductionRender::EndSequence()
+{
+    StopRender();
+
+    _isSequenceMode = false;
+    ClearHydraResources();
+
+    // All frames should be on disk once the sequence command returns
+    if (_imageWriter) {
+        _imageWriter->Flush();
+    }
+}
+
+bool RprUsdProductionRender::FlushImages(MStringArray& imagePaths)
+{
+    imagePaths = _unflushedImagePaths;
+    _unflushedImagePaths.clear();
+
+    return !_imageWriter || _imageWriter->Flush();
+}
+
 void RprUsdProductionRender::ApplySettings()
 {
-    ProductionSettings::ApplySettings(_GetRenderDelegate());
+    _settingsHash = ProductionSettings::ApplySettings(_GetRenderDelegate());
+
+    _isSampleBudgetApplied = _isSequenceMode && ProductionSettings::IsTemporalSampleBudgetEnabled();
+    if (_isSampleBudgetApplied) {
+        // Cameras of a frame see different parts of the scene and converge differently
+        _sampleBudget = &_sampleBudgets[GetCameraName()];
+
+        const GfVec2i budgetRange = ProductionSettings::GetSampleBudgetRange();
+        _settingsHash = _sampleBudget->Apply(
+            _GetRenderDelegate(), _settingsHash, budgetRange[0], budgetRange[1]);
+        OutputInfoToMayaConsoleCommon(
+            MString("Sample budget: ") + std::to_string(_sampleBudget->GetBudget()).c_str()
+            + ", noise threshold: " + std::to_string(_sampleBudget->GetNoiseThreshold()).c_str());
+    }
+}
+
+void RprUsdProductionRender::SetupRenderOutputs()
+{
+    HdRenderDelegate* renderDelegate = _GetRenderDelegate();
+
+    // All AOVs are rendered in the same pass, color is always the first one
+    TfTokenVector aovs = { HdAovTokens->color };
+
+    for (const TfToken& aov : ProductionSettings::GetAovs()) {
+        if (std::find(aovs.begin(), aovs.end(), aov) != aovs.end()) {
+            continue;
+        }
+
+        if (renderDelegate->GetDefaultAovDescriptor(aov).format == HdFormatInvalid) {
+            OutputWarningToMayaConsoleCommon(MString("AOV is not supported: ") + aov.GetText());
+            continue;
+        }
+
+        aovs.push_back(aov);
+    }
+
+    if (aovs != _aovs) {
+        _aovs = aovs;
+        _taskController->SetRenderOutputs(_aovs);
+        _taskController->SetViewportRenderOutput(HdAovTokens->color);
+    }
 }
 
 void RprUsdProductionRender::StopRender()
@@ -253,99 +710,685 @@ void RprUsdProductionRender::StopRender()
         return;
     }
 
-    // call abort render somehow
-
-    RefreshRenderView();
-    SaveToFile();
-    _renderProgressBars.reset();
-
-    MRenderView::endRender();
-
+    // Abort the current iteration right away, render buffers keep what is already rendered
     HdRenderDelegate* renderDelegate = _renderIndex->GetRenderDelegate();
     assert(renderDelegate);
     renderDelegate->Stop();
 
+    if (_tiledRender) {
+        EndTiledRender();
+    }
+
+    // Partial image of a cancelled render is kept only on request, IPR image is never saved
+    const bool saveImage = !_isIprMode
+        && (!_isCancelled || ProductionSettings::IsCancelledFrameSavingEnabled());
+
+    // Tiled render has no Render View image and writes the file itself
+    const bool useRenderView = !_isHeadless && !_isTiledRender;
+
+    if (useRenderView && saveImage) {
+        RefreshRenderView(true);
+    }
+
+    if (!_isTiledRender && saveImage) {
+        SaveToFile();
+    }
+    _renderProgressBars.reset();
+
+    if (useRenderView) {
+        MRenderView::endRender();
+    }
+
+    TimePoint     currentTime = GetCurrentChronoTime();
+    unsigned long renderMiliseconds
+        = TimeDiffChrono<std::chrono::milliseconds>(currentTime, _syncFinishedTime);
     unsigned long totalRenderMiliseconds
-        = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), _startRenderTime);
+        = TimeDiffChrono<std::chrono::milliseconds>(currentTime, _startRenderTime);
+    OutputInfoToMayaConsole("Render Time", renderMiliseconds);
     OutputInfoToMayaConsole("Total Render Time", totalRenderMiliseconds);
 
+    if (!_isIprMode) {
+        WriteRenderStats(currentTime);
+    }
+
+    // Cancelled frame didn't show how many samples the frame needs
+    if (_isSampleBudgetApplied && !_isCancelled) {
+        _sampleBudget->Update(GetCompletedSamples());
+    }
+
     // unregsiter timer callback
     MTimerMessage::removeCallback(_callbackTimerId);
     _callbackTimerId = 0;
 
     restoreRenderLayer(_oldLayerName, _newLayerName);
 
-    ClearHydraResources();
+    if (!_isSequenceMode) {
+        ClearHydraResources();
+
+        // batch process may quit right after the command returns
+        if (_isHeadless && _imageWriter) {
+            _imageWriter->Flush();
+        }
+    }
     _renderIsStarted = false;
+    _isTiledRender = false;
     _additionalStatsWasOutput = false;
 }
 
-void RprUsdProductionRender::SaveToFile()
+MString RprUsdProductionRender::GetImagePath() const
+{
+    MCommonRenderSettingsData settings;
+    MRenderUtil::getCommonRenderSettings(settings);
+
+    MString sceneName = settings.name;
+
+    // Populate the scene name with the current namespace - this
+    // should be equivalent to the scene name and is how Maya generates
+    // it for post render operations such as layered PSD creation.
+    if (sceneName.length() <= 0) {
+        MStringArray results;
+        MGlobal::executeCommand("file -q -ns", results);
+
+        if (results.length() > 0)
+            sceneName = results[0];
+    }
+
+    // Prim names repeat in different scopes, the whole path keeps USD camera images apart
+    MString cameraName = _usdCameraPath.IsEmpty()
+        ? MFnDagNode(_camPath.transform()).name()
+        : MString(TfStringReplace(_usdCameraPath.GetString().substr(1), "/", "_").c_str());
+    unsigned int frame = static_cast<unsigned int>(MAnimControl::currentTime().value());
+
+    return settings.getImageName(
+        MCommonRenderSettingsData::kFullPathImage,
+        frame,
+        sceneName,
+        cameraName,
+        "",
+        MFnRenderLayer::currentLayer());
+}
+
+void RprUsdProductionRender::SaveToFile()
+{
+    MString fullPath = GetImagePath();
+
+    // Partial image of a cancelled frame must not take the place of the finished one
+    const bool isPartial = _isCancelled;
+    if (isPartial) {
+        fullPath = ImageWriter::GetPartialImagePath(fullPath.asChar()).c_str();
+    }
+
+    if (SaveToFileAsync(fullPath)) {
+        if (!isPartial) {
+            _unflushedImagePaths.append(fullPath);
+        }
+        return;
+    }
+
+    if (_isHeadless) {
+        MGlobal::displayError(
+            "[hdRPR] Render image could not be saved, image format is not supported in headless "
+            "mode: "
+            + fullPath);
+        return;
+    }
+
+    // remove existing file to avoid file replace confirmation prompt
+    MGlobal::executeCommand("sysFile -delete \"" + fullPath + "\"");
+
+    // Render View adds the extension of the image format itself
+    MString pathWithoutExtension = fullPath;
+    int     dotIndex = fullPath.rindex('.');
+
+    if (dotIndex > 0) {
+        pathWithoutExtension = fullPath.substring(0, dotIndex - 1);
+    }
+
+    std::string cmd = TfStringPrintf(
+        "$editor = `renderWindowEditor -q -editorName`; renderWindowEditor -e -writeImage \"%s\" "
+        "$editor",
+        pathWithoutExtension.asChar());
+
+    MStatus status = MGlobal::executeCommand(cmd.c_str());
+
+    if (status != MStatus::kSuccess) {
+        MGlobal::displayError("[hdRPR] Render image could not be saved!");
+        return;
+    }
+
+    if (!isPartial) {
+        _unflushedImagePaths.append(fullPath);
+    }
+}
+
+std::vector<std::string> GetAovChannelNames(const TfToken& aov, size_t componentCount)
+{
+    static const char* kColorComponents[] = { "R", "G", "B", "A" };
+
+    std::vector<std::string> channelNames;
+
+    // Beauty goes to the default RGBA layer, other AOVs to named layers
+    std::string layerPrefix = aov == HdAovTokens->color ? "" : aov.GetString() + ".";
+
+    if (componentCount == 1) {
+        channelNames.push_back(layerPrefix + (aov == HdAovTokens->depth ? "Z" : "R"));
+        return channelNames;
+    }
+
+    for (size_t i = 0; i < componentCount && i < 4; ++i) {
+        channelNames.push_back(layerPrefix + kColorComponents[i]);
+    }
+
+    return channelNames;
+}
+
+float ReadComponentAsFloat(const uint8_t* data, HdFormat componentFormat)
+{
+    switch (componentFormat) {
+    case HdFormatUNorm8:
+        return *data / 255.0f;
+    case HdFormatSNorm8:
+        return std::max(*reinterpret_cast<const int8_t*>(data) / 127.0f, -1.0f);
+    case HdFormatFloat16:
+        return float(*reinterpret_cast<const GfHalf*>(data));
+    case HdFormatFloat32:
+        return *reinterpret_cast<const float*>(data);
+    case HdFormatInt32:
+        return float(*reinterpret_cast<const int32_t*>(data));
+    default:
+        return 0.0f;
+    }
+}
+
+bool ReadRenderBuffer(const TfToken& aov, HdRenderBuffer* bufferPtr, ImageWriter::Layer& layer)
+{
+    HdFormat format = bufferPtr->GetFormat();
+    HdFormat componentFormat = HdGetComponentFormat(format);
+    size_t   componentCount = HdGetComponentCount(format);
+    size_t   componentSize = HdDataSizeOfFormat(componentFormat);
+
+    if (componentFormat == HdFormatInvalid || componentCount == 0) {
+        return false;
+    }
+
+    size_t pixelCount = size_t(bufferPtr->GetWidth()) * bufferPtr->GetHeight();
+
+    layer.channelNames = GetAovChannelNames(aov, componentCount);
+    layer.pixels.resize(pixelCount * layer.channelNames.size());
+
+    // Ids above 2^24 collide in float, their bits are kept as is
+    layer.integerPixels = componentFormat == HdFormatInt32;
+
+    const uint8_t* rawBuffer = static_cast<const uint8_t*>(bufferPtr->Map());
+    if (!rawBuffer) {
+        return false;
+    }
+
+    if ((componentFormat == HdFormatFloat32 || layer.integerPixels)
+        && componentCount == layer.channelNames.size()) {
+        std::memcpy(layer.pixels.data(), rawBuffer, layer.pixels.size() * sizeof(float));
+    } else {
+        const size_t channelCount = layer.channelNames.size();
+        for (size_t i = 0; i < pixelCount; ++i) {
+            const uint8_t* pixel = rawBuffer + i * componentCount * componentSize;
+
+            for (size_t c = 0; c < channelCount; ++c) {
+                if (layer.integerPixels) {
+                    std::memcpy(
+                        &layer.pixels[i * channelCount + c],
+                        pixel + c * componentSize,
+                        sizeof(float));
+                } else {
+                    layer.pixels[i * channelCount + c]
+                        = ReadComponentAsFloat(pixel + c * componentSize, componentFormat);
+                }
+            }
+        }
+    }
+
+    bufferPtr->Unmap();
+
+    return true;
+}
+
+bool RprUsdProductionRender::SaveToFileAsync(const MString& fullPath)
+{
+    std::string path = fullPath.asChar();
+    if (!ImageWriter::IsSupportedFormat(path)) {
+        return false;
+    }
+
+    HdRenderBuffer* bufferPtr = _taskController->GetRenderOutput(HdAovTokens->color);
+    if (!bufferPtr || bufferPtr->GetFormat() != HdFormatFloat32Vec4) {
+        return false;
+    }
+
+    unsigned int width = bufferPtr->GetWidth();
+    unsigned int height = bufferPtr->GetHeight();
+
+    bool writeAovs = _aovs.size() > 1;
+    if (writeAovs && !ImageWriter::IsMultiLayerFormat(path)) {
+        OutputWarningToMayaConsoleCommon(
+            "AOVs are written only to the multi-layer EXR image format, saving color only");
+        writeAovs = false;
+    }
+
+    // Copy pixels, so render buffers could be reused by the next frame while the image is encoded
+    std::vector<ImageWriter::Layer> layers;
+
+    for (const TfToken& aov : _aovs) {
+        HdRenderBuffer* aovBufferPtr = _taskController->GetRenderOutput(aov);
+        if (!aovBufferPtr || aovBufferPtr->GetWidth() != width
+            || aovBufferPtr->GetHeight() != height) {
+            continue;
+        }
+
+        ImageWriter::Layer layer;
+        if (ReadRenderBuffer(aov, aovBufferPtr, layer)) {
+            layers.push_back(std::move(layer));
+        }
+
+        if (!writeAovs) {
+            break;
+        }
+    }
+
+    if (layers.empty()) {
+        return false;
+    }
+
+    if (HasRenderRegion()) {
+        CompositeRegionIntoLastFrame(layers);
+        width = _lastFrameWidth;
+        height = _lastFrameHeight;
+    } else if (!_isHeadless && !_isSequenceMode) {
+        // Kept for region re-renders, batch and sequence renders don't need it
+        _lastFrameLayers = layers;
+        _lastFrameWidth = width;
+        _lastFrameHeight = height;
+        _lastFrameTime = MAnimControl::currentTime().value();
+        _lastFrameCamera = GetCameraName();
+    } else {
+        ReleaseLastFrame();
+    }
+
+    if (!_imageWriter) {
+        _imageWriter = std::make_unique<ImageWriter>();
+    }
+
+    // Checksum marks a finished frame, partial image of a cancelled one never gets it
+    _imageWriter->SetWriteChecksums(
+        ProductionSettings::IsChecksumWritingEnabled() && !_isCancelled);
+    _imageWriter->Write(path, width, height, std::move(layers));
+
+    return true;
+}
+
+void RprUsdProductionRender::CompositeRegionIntoLastFrame(std::vector<ImageWriter::Layer>& layers)
+{
+    bool lastFrameMatches = _lastFrameWidth == _imageWidth && _lastFrameHeight == _imageHeight
+        && _lastFrameTime == MAnimControl::currentTime().value()
+        && _lastFrameCamera == GetCameraName() && _lastFrameLayers.size() == layers.size();
+
+    for (size_t i = 0; lastFrameMatches && i < layers.size(); ++i) {
+        lastFrameMatches = _lastFrameLayers[i].channelNames == layers[i].channelNames;
+    }
+
+    // Without a matching full frame the region is written over the black image
+    if (!lastFrameMatches) {
+        ReleaseLastFrame();
+        _lastFrameLayers.resize(layers.size());
+        for (size_t i = 0; i < layers.size(); ++i) {
+            _lastFrameLayers[i].channelNames = layers[i].channelNames;
+            _lastFrameLayers[i].integerPixels = layers[i].integerPixels;
+            _lastFrameLayers[i].pixels.assign(
+                size_t(_imageWidth) * _imageHeight * layers[i].channelNames.size(), 0.0f);
+        }
+        _lastFrameWidth = _imageWidth;
+        _lastFrameHeight = _imageHeight;
+        _lastFrameTime = MAnimControl::currentTime().value();
+        _lastFrameCamera = GetCameraName();
+    }
+
+    // Both images are stored bottom row first, same as region coordinates
+    const size_t regionX = _renderRegion[0];
+    const size_t regionY = _renderRegion[1];
+    const size_t regionWidth = _renderRegion[2];
+    const size_t regionHeight = _renderRegion[3];
+
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const size_t channelCount = layers[i].channelNames.size();
+        const float* src = layers[i].pixels.data();
+        float*       dst = _lastFrameLayers[i].pixels.data();
+
+        for (size_t y = 0; y < regionHeight; ++y) {
+            std::memcpy(
+                dst + ((regionY + y) * _imageWidth + regionX) * channelCount,
+                src + y * regionWidth * channelCount,
+                regionWidth * channelCount * sizeof(float));
+        }
+
+        layers[i].pixels = _lastFrameLayers[i].pixels;
+    }
+}
+
+void RprUsdProductionRender::ReleaseLastFrame()
+{
+    // clear() keeps the capacity, gigabytes at 8K
+    std::vector<ImageWriter::Layer>().swap(_lastFrameLayers);
+    _lastFrameWidth = 0;
+    _lastFrameHeight = 0;
+    _lastFrameCamera.clear();
+}
+
+std::string RprUsdProductionRender::GetCameraName() const
+{
+    UsdPrim cameraPrim = GetUsdCameraPrim();
+    if (cameraPrim.IsValid()) {
+        return cameraPrim.GetPath().GetString();
+    }
+
+    return _camPath.partialPathName().asChar();
+}
+
+// Tiles are rendered with a margin, so the pixel filter sees the same neighbourhood as in the
+// full frame render and tile seams don't show
+static const unsigned int kTileOverlap = 8;
+
+bool RprUsdProductionRender::BeginTiledRender(unsigned int tileSize)
+{
+    // Tiled image replaces the last frame on disk, and is too large to be kept anyway
+    ReleaseLastFrame();
+
+    std::string path = GetImagePath().asChar();
+    if (!ImageWriter::IsMultiLayerFormat(path)) {
+        MGlobal::displayError(
+            MString("[hdRPR] Tiled render is saved only to EXR format: ") + path.c_str());
+        _isCancelled = true;
+        return false;
+    }
+
+    if (!_isHeadless) {
+        _renderProgressBars = std::make_unique<RenderProgressBars>(false);
+    }
+
+    ApplySettings();
+
+    // Denoiser sees only the tile, denoised tiles wouldn't match at the seams.
+    // The next ApplySettings pushes the artist's value back.
+    HdRenderDelegate* renderDelegate = _GetRenderDelegate();
+    VtValue           denoising = renderDelegate->GetRenderSetting(_tokens->denoisingEnable);
+    if (denoising.IsHolding<bool>() && denoising.UncheckedGet<bool>()) {
+        ProductionSettings::ApplyOverride(
+            renderDelegate, _tokens->denoisingEnable, VtValue(false));
+        OutputWarningToMayaConsoleCommon("Denoising is disabled for tiled render");
+    }
+
+    _tiledRender = std::make_unique<TiledRender>();
+    _tiledRender->path = path;
+    _tiledRender->tileSize = tileSize;
+    _tiledRender->tilesX = (_imageWidth + tileSize - 1) / tileSize;
+    _tiledRender->tilesY = (_imageHeight + tileSize - 1) / tileSize;
+
+    OutputInfoToMayaConsoleCommon(
+        MString("Tiled render: ") + std::to_string(_tiledRender->tilesX).c_str() + "x"
+        + std::to_string(_tiledRender->tilesY).c_str() + " tiles");
+
+    StartTile();
+    return true;
+}
+
+void RprUsdProductionRender::StartTile()
+{
+    TiledRender& tiled = *_tiledRender;
+
+    tiled.tileX0 = (tiled.tile % tiled.tilesX) * tiled.tileSize;
+    tiled.bandY0 = (tiled.tile / tiled.tilesX) * tiled.tileSize;
+    tiled.tileWidth = std::min(tiled.tileSize, _imageWidth - tiled.tileX0);
+    tiled.bandHeight = std::min(tiled.tileSize, _imageHeight - tiled.bandY0);
+
+    // Tile with overlap, clamped to the image
+    const unsigned int renderX0 = tiled.tileX0 > kTileOverlap ? tiled.tileX0 - kTileOverlap : 0;
+    const unsigned int renderY0 = tiled.bandY0 > kTileOverlap ? tiled.bandY0 - kTileOverlap : 0;
+    const unsigned int renderX1
+        = std::min(tiled.tileX0 + tiled.tileWidth + kTileOverlap, _imageWidth);
+    const unsigned int renderY1
+        = std::min(tiled.bandY0 + tiled.bandHeight + kTileOverlap, _imageHeight);
+
+    _renderRegion = GfVec4i(renderX0, renderY0, renderX1 - renderX0, renderY1 - renderY0);
+    _viewport = GfVec4d(0, 0, _renderRegion[2], _renderRegion[3]);
+
+    if (tiled.tile > 0) {
+        _GetRenderDelegate()->Restart();
+    }
+
+    // Converged state of the previous tile must not end this one
+    MarkRestarted();
+
+    Render(tiled.tile == 0);
+    SampleMemoryUsage();
+}
+
+bool RprUsdProductionRender::ProcessTile()
+{
+    _isCancelled = _renderProgressBars && _renderProgressBars->isCancelled();
+    if (_isCancelled) {
+        StopRender();
+        return false;
+    }
+
+    HdRenderBuffer* bufferPtr = _taskController->GetRenderOutput(HdAovTokens->color);
+    assert(bufferPtr);
+
+    if (!IsRenderConverged(bufferPtr)) {
+        return true;
+    }
+
+    TiledRender& tiled = *_tiledRender;
+
+    if (!WriteTile()) {
+        tiled.failed = true;
+        _isCancelled = true;
+        StopRender();
+        return false;
+    }
+
+    const unsigned int tileCount = tiled.tilesX * tiled.tilesY;
+    ++tiled.tile;
+
+    if (_renderProgressBars) {
+        _renderProgressBars->update(int(100 * tiled.tile / tileCount));
+    } else {
+        OutputInfoToMayaConsoleCommon(
+            MString("Tile ") + std::to_string(tiled.tile).c_str() + "/"
+            + std::to_string(tileCount).c_str() + " done");
+    }
+
+    if (tiled.tile == tileCount) {
+        StopRender();
+        return false;
+    }
+
+    StartTile();
+    return true;
+}
+
+bool RprUsdProductionRender::WriteTile()
+{
+    TiledRender& tiled = *_tiledRender;
+
+    std::vector<ImageWriter::Layer> layers;
+    for (const TfToken& aov : _aovs) {
+        ImageWriter::Layer layer;
+        HdRenderBuffer*    aovBufferPtr = _taskController->GetRenderOutput(aov);
+        if (aovBufferPtr && ReadRenderBuffer(aov, aovBufferPtr, layer)) {
+            layers.push_back(std::move(layer));
+        }
+    }
+
+    if (tiled.channelNames.empty()) {
+        for (const ImageWriter::Layer& layer : layers) {
+            tiled.channelNames.insert(
+                tiled.channelNames.end(), layer.channelNames.begin(), layer.channelNames.end());
+            tiled.uintChannels.insert(
+                tiled.uintChannels.end(), layer.channelNames.size(), layer.integerPixels);
+        }
+
+        if (!tiled.exrWriter.Open(
+                tiled.path, _imageWidth, _imageHeight, tiled.channelNames, tiled.uintChannels)) {
+            MGlobal::displayError(
+                MString("[hdRPR] Render image could not be saved: ") + tiled.path.c_str());
+            return false;
+        }
+    }
+
+    const size_t pixelSize = tiled.channelNames.size();
+    tiled.band.resize(size_t(_imageWidth) * tiled.tileSize * pixelSize);
+
+    // Copy the tile without the overlap into the band
+    const size_t offsetX = tiled.tileX0 - _renderRegion[0];
+    const size_t offsetY = tiled.bandY0 - _renderRegion[1];
+
+    size_t channelOffset = 0;
+    for (const ImageWriter::Layer& layer : layers) {
+        const size_t layerChannels = layer.channelNames.size();
+
+        for (size_t y = 0; y < tiled.bandHeight; ++y) {
+            const float* src = layer.pixels.data()
+                + ((offsetY + y) * _renderRegion[2] + offsetX) * layerChannels;
+            float* dst = tiled.band.data() + (y * _imageWidth + tiled.tileX0) * pixelSize
+                + channelOffset;
+
+            // Copied as bits, integer AOVs must not go through float conversion
+            for (size_t x = 0; x < tiled.tileWidth; ++x) {
+                std::memcpy(
+                    dst + x * pixelSize, src + x * layerChannels, layerChannels * sizeof(float));
+            }
+        }
+        channelOffset += layerChannels;
+    }
+
+    // Band is complete after its last tile
+    if (tiled.tileX0 + tiled.tileWidth < _imageWidth) {
+        return true;
+    }
+
+    // Band rows go bottom to top, exr scanlines top to bottom
+    for (unsigned int y = 0; y < tiled.bandHeight; ++y) {
+        const float* line = tiled.band.data() + size_t(y) * _imageWidth * pixelSize;
+        if (!tiled.exrWriter.WriteScanline(_imageHeight - 1 - (tiled.bandY0 + y), line)) {
+            MGlobal::displayError(
+                MString("[hdRPR] Render image could not be saved: ") + tiled.path.c_str());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RprUsdProductionRender::EndTiledRender()
 {
-    MCommonRenderSettingsData settings;
-    MRenderUtil::getCommonRenderSettings(settings);
-
-    MString sceneName = settings.name;
+    TiledRender& tiled = *_tiledRender;
 
-    // Populate the scene name with the current namespace - this
-    // should be equivalent to the scene name and is how Maya generates
-    // it for post render operations such as layered PSD creation.
-    if (sceneName.length() <= 0) {
-        MStringArray results;
-        MGlobal::executeCommand("file -q -ns", results);
+    // Render stopped from outside before all tiles were done
+    if (tiled.tile < tiled.tilesX * tiled.tilesY) {
+        _isCancelled = true;
+    }
 
-        if (results.length() > 0)
-            sceneName = results[0];
+    // Failed scanline write leaves the stream bad, so Close fails too and the file is broken
+    if (!tiled.exrWriter.Close() || tiled.failed) {
+        if (!_isCancelled || !tiled.failed) {
+            MGlobal::displayError(
+                MString("[hdRPR] Render image could not be saved: ") + tiled.path.c_str());
+        }
+        _isCancelled = true;
+        std::remove(tiled.path.c_str());
+    } else if (_isCancelled) {
+        // Bands which were not rendered are left empty in the file, it passes the EXR header
+        // check, so it's kept under the partial name for resume to render the frame again
+        const std::string partialPath = ImageWriter::GetPartialImagePath(tiled.path);
+        std::remove(partialPath.c_str());
+        if (!ProductionSettings::IsCancelledFrameSavingEnabled()
+            || std::rename(tiled.path.c_str(), partialPath.c_str()) != 0) {
+            std::remove(tiled.path.c_str());
+        }
+    } else {
+        if (ProductionSettings::IsChecksumWritingEnabled()) {
+            ImageWriter::WriteChecksum(tiled.path);
+        }
+        _unflushedImagePaths.append(tiled.path.c_str());
     }
 
-    MString      cameraName = MFnDagNode(_camPath.transform()).name();
-    unsigned int frame = static_cast<unsigned int>(MAnimControl::currentTime().value());
+    _renderRegion = GfVec4i(0, 0, 0, 0);
+    _viewport = GfVec4d(0, 0, _imageWidth, _imageHeight);
+    _isConverged = !_isCancelled;
+    _tiledRender.reset();
+}
 
-    MString fullPath = settings.getImageName(
-        MCommonRenderSettingsData::kFullPathImage,
-        frame,
-        sceneName,
-        cameraName,
-        "",
-        MFnRenderLayer::currentLayer());
+// Render View push costs about the same per pixel whatever changed, so during progressive
+// rendering a large image is refreshed a band of rows at a time and never hashed or compared
+static const size_t kRenderViewPixelsPerRefresh = 3840 * 2160 / 2;
 
-    // remove existing file to avoid file replace confirmation prompt
-    MGlobal::executeCommand("sysFile -delete \"" + fullPath + "\"");
+void RprUsdProductionRender::RefreshRenderView(bool fullRefresh)
+{
+    // _TODO Remove constants
+    unsigned int width = (unsigned int)_viewport.GetArray()[2];
+    unsigned int height = (unsigned int)_viewport.GetArray()[3];
 
-    int dotIndex = fullPath.rindex('.');
+    const int64_t samples = GetCompletedSamples();
 
-    if (dotIndex > 0) {
-        fullPath = fullPath.substring(0, dotIndex - 1);
-    }
+    // Rows are contiguous in the buffer, so bands are pushed without a copy
+    unsigned int y0 = 0;
+    unsigned int y1 = height - 1;
 
-    std::string cmd = TfStringPrintf(
-        "$editor = `renderWindowEditor -q -editorName`; renderWindowEditor -e -writeImage \"%s\" "
-        "$editor",
-        fullPath.asChar());
+    if (fullRefresh) {
+        _renderViewNextRow = height;
+        _renderViewSamples = samples;
+    } else {
+        // Progressive band is pointless once the render is about to be stopped
+        if (_renderProgressBars && _renderProgressBars->isCancelled()) {
+            return;
+        }
 
-    MStatus status = MGlobal::executeCommand(cmd.c_str());
+        if (_renderViewNextRow >= height) {
+            // Whole image in Render View already has these samples
+            if (samples >= 0 && samples == _renderViewSamples) {
+                return;
+            }
+            _renderViewNextRow = 0;
+        }
 
-    if (status != MStatus::kSuccess) {
-        MGlobal::displayError("[hdRPR] Render image could not be saved!");
+        if (_renderViewNextRow == 0) {
+            _renderViewSamples = samples;
+        }
+
+        const unsigned int rowsPerRefresh
+            = (unsigned int)std::max<size_t>(1, kRenderViewPixelsPerRefresh / width);
+        y0 = _renderViewNextRow;
+        y1 = std::min(y0 + rowsPerRefresh, height) - 1;
+        _renderViewNextRow = y1 + 1;
     }
-}
 
-void RprUsdProductionRender::RefreshRenderView()
-{
     HdRenderBuffer* bufferPtr = _taskController->GetRenderOutput(HdAovTokens->color);
     assert(bufferPtr);
 
     RV_PIXEL* rawBuffer = static_cast<RV_PIXEL*>(bufferPtr->Map());
 
-    // _TODO Remove constants
-    unsigned int width = (unsigned int)_viewport.GetArray()[2];
-    unsigned int height = (unsigned int)_viewport.GetArray()[3];
+    // Render View coordinates are in the full image when only a region is rendered
+    const unsigned int offsetX = HasRenderRegion() ? _renderRegion[0] : 0;
+    const unsigned int offsetY = HasRenderRegion() ? _renderRegion[1] : 0;
 
     // Update the render view pixels.
-    MRenderView::updatePixels(0, width - 1, 0, height - 1, rawBuffer, true);
+    MRenderView::updatePixels(
+        offsetX,
+        offsetX + width - 1,
+        offsetY + y0,
+        offsetY + y1,
+        rawBuffer + size_t(y0) * width,
+        true);
 
     // Refresh the render view.
-    MRenderView::refresh(0, width - 1, 0, height - 1);
+    MRenderView::refresh(offsetX, offsetX + width - 1, offsetY + y0, offsetY + y1);
 
     bufferPtr->Unmap();
 }
@@ -356,18 +1399,13 @@ bool RprUsdProductionRender::InitHydraResources()
     GlfGlewInit();
 #endif
     GlfContextCaps::InitInstance();
-    _rendererPlugin = HdRendererPluginRegistry::GetInstance().GetRendererPlugin(_rendererName);
-    if (!_rendererPlugin)
-        return false;
-
-    auto* renderDelegate = _rendererPlugin->CreateRenderDelegate();
-    if (!renderDelegate)
-        return false;
-
-    _renderIndex = HdRenderIndex::New(renderDelegate, { &_hgiDriver });
+    _renderIndex = _delegatePool.Acquire(_rendererName, { &_hgiDriver }, &_rendererPlugin);
     if (!_renderIndex)
         return false;
 
+    // New delegate may get the address of a deleted one
+    ProductionSettings::ResetAppliedSettings();
+
     _taskController = new HdxTaskController(
         _renderIndex,
         _ID.AppendChild(TfToken(TfStringPrintf(
@@ -441,9 +1479,18 @@ bool RprUsdProductionRender::InitHydraResources()
         _defaultLightDelegate.reset(new MtohDefaultLightDelegate(delegateInitData));
     }
 
+    // Objects and Maya cameras are sampled over the shutter for motion blur
+    const GfVec2f motionSampleInterval = ProductionSettings::GetMotionSampleInterval();
+
+    HdMayaParams delegateParams;
+    delegateParams.motionSampleStart = motionSampleInterval[0];
+    delegateParams.motionSampleEnd = motionSampleInterval[1];
+
     for (auto& it : _delegates) {
+        it->SetParams(delegateParams);
         it->Populate();
     }
+    _hasMotionSamples = delegateParams.motionSamplesEnabled();
 
     if (pMayaSceneDelegate) {
         HdMayaProxyAdapter* pProxyAdapter = static_cast<HdMayaProxyAdapter*>(
@@ -461,6 +1508,9 @@ bool RprUsdProductionRender::InitHydraResources()
 
             pImagingDelegate->SetTime(pShapeBase->getTime());
             pImagingDelegate->SetSceneMaterialsEnabled(true);
+
+            _pImagingDelegate = pImagingDelegate;
+            _pProxyShapeBase = pShapeBase;
         }
     }
 
@@ -472,6 +1522,65 @@ bool RprUsdProductionRender::InitHydraResources()
     return true;
 }
 
+bool RprUsdProductionRender::InitSharedHydraResources()
+{
+    // Viewport scene time isn't advanced without a viewport draw, so sequences and batch renders
+    // always sync their own scene. IPR would keep the viewport blocked for all its lifetime.
+    if (_isSequenceMode || _isHeadless || _isIprMode
+        || !ProductionSettings::IsViewportSceneReuseEnabled()) {
+        return false;
+    }
+
+    _renderIndex = MtohRenderOverride::AcquireRenderIndex(
+        _rendererName, [this]() { OnSharedRenderIndexRevoked(); });
+    if (!_renderIndex) {
+        return false;
+    }
+
+    // Own task controller renders to its own render buffers with production camera and
+    // resolution, scene prims are shared with the viewport
+    _taskController = new HdxTaskController(
+        _renderIndex,
+        _ID.AppendChild(TfToken(TfStringPrintf(
+            "_UsdImaging_%s_%p", TfMakeValidIdentifier(_rendererName.GetText()).c_str(), this))));
+    _taskController->SetEnableShadows(true);
+
+    OutputInfoToMayaConsoleCommon("Reusing the scene synced by the viewport");
+
+    _isSharedRenderIndex = true;
+    _initialized = true;
+    return true;
+}
+
+void RprUsdProductionRender::OnSharedRenderIndexRevoked()
+{
+    OutputWarningToMayaConsoleCommon("Viewport scene was cleared, render is stopped");
+
+    // Stopped render returns the index with the rest of Hydra resources
+    if (_renderIsStarted) {
+        _isCancelled = true;
+        StopRender();
+    } else {
+        ClearHydraResources();
+    }
+}
+
+void RprUsdProductionRender::UpdateHydraResourcesTime()
+{
+    // Maya DG changes caused by the time switch are tracked by the hdMaya adapters callbacks.
+    // Usd imaging delegate has to be told explicitly, it marks time varying prims as dirty.
+    if (_pImagingDelegate && _pProxyShapeBase) {
+        _pImagingDelegate->SetTime(_pProxyShapeBase->getTime());
+    }
+
+    // Renderer was stopped at the end of the previous frame or camera. It's restarted even if only
+    // the camera changed, nothing in the scene is dirty to restart it then.
+    HdRenderDelegate* renderDelegate = _GetRenderDelegate();
+    if (renderDelegate) {
+        renderDelegate->Restart();
+    }
+}
+
 HdRenderDelegate* RprUsdProductionRender::_GetRenderDelegate()
 {
     return _renderIndex ? _renderIndex->GetRenderDelegate() : nullptr;
@@ -479,7 +1588,13 @@ HdRenderDelegate* RprUsdProductionRender::_GetRenderDelegate()
 
 void RprUsdProductionRender::ClearHydraResources()
 {
+    _initialized = false;
+    _aovs.clear();
+    _pImagingDelegate = nullptr;
+    _pProxyShapeBase = nullptr;
+
     _delegates.clear();
+    _hasMotionSamples = false;
     _defaultLightDelegate.reset();
 
     if (_taskController != nullptr) {
@@ -487,23 +1602,24 @@ void RprUsdProductionRender::ClearHydraResources()
         _taskController = nullptr;
     }
 
-    HdRenderDelegate* renderDelegate = nullptr;
-    if (_renderIndex != nullptr) {
-        renderDelegate = _renderIndex->GetRenderDelegate();
-        delete _renderIndex;
+    if (_isSharedRenderIndex) {
+        _isSharedRenderIndex = false;
         _renderIndex = nullptr;
+        MtohRenderOverride::ReleaseRenderIndex(_rendererName);
+        return;
     }
 
     if (_rendererPlugin != nullptr) {
-        if (renderDelegate != nullptr) {
-            _rendererPlugin->DeleteRenderDelegate(renderDelegate);
-        }
-        HdRendererPluginRegistry::GetInstance().ReleasePlugin(_rendererPlugin);
+        // Scene and task prims are removed with their delegates above, the emptied index stays
+        // alive with its delegate for a while, so the next render doesn't have to recreate them
+        _delegatePool.Release(
+            _rendererPlugin, _renderIndex, ProductionSettings::GetDelegateIdleTimeout());
         _rendererPlugin = nullptr;
     }
+    _renderIndex = nullptr;
 }
 
-MStatus RprUsdProductionRender::Render()
+MStatus RprUsdProductionRender::Render(bool outputSyncTime)
 {
     auto renderFrame = [&](bool markTime = false) {
         HdTaskSharedPtrVector tasks = _taskController->GetRenderingTasks();
@@ -526,18 +1642,145 @@ MStatus RprUsdProductionRender::Render()
     params.enableLighting = true;
     params.enableSceneMaterials = true;
 
+    SetupRenderOutputs();
+
     _taskController->SetRenderViewport(_viewport);
 
-    MStatus status;
+    ComputeCameraMatrices(_lastViewMatrix, _lastProjectionMatrix);
+    _taskController->SetFreeCameraMatrices(_lastViewMatrix, _lastProjectionMatrix);
+
+    // Camera sprim replaces the free camera, it has transform samples over the shutter
+    params.camera = GetMotionBlurCameraId();
+
+    _taskController->SetEnablePresentation(false);
+
+    _taskController->SetRenderParams(params);
+    if (!params.camera.IsEmpty())
+        _taskController->SetCameraPath(params.camera);
+
+    // Default color in usdview.
+    _taskController->SetEnableSelection(false);
+
+    _taskController->SetCollection(_renderCollection);
+
+    renderFrame(true);
+
+    if (outputSyncTime) {
+        OutputHardwareSetupAndSyncTime();
+    }
+
+    for (auto& it : _delegates) {
+        it->PostFrame();
+    }
+
+    // Changes after this point are picked up by IPR
+    _lastSceneStateVersion = _renderIndex->GetChangeTracker().GetSceneStateVersion();
+
+    return MStatus::kSuccess;
+}
+
+SdfPath RprUsdProductionRender::GetMotionBlurCameraId()
+{
+    // Region crop is applied to the free camera projection only. Shared scene has viewport
+    // delegate params, which don't match the production shutter.
+    if (!_hasMotionSamples || HasRenderRegion() || _isSharedRenderIndex) {
+        return SdfPath();
+    }
+
+    UsdPrim cameraPrim = GetUsdCameraPrim();
+    if (cameraPrim.IsValid()) {
+        // Usd camera is sampled over the shutter authored on the camera
+        if (!_pImagingDelegate) {
+            return SdfPath();
+        }
+
+        _pImagingDelegate->SetCameraForSampling(cameraPrim.GetPath());
+        return _pImagingDelegate->ConvertCachePathToIndexPath(cameraPrim.GetPath());
+    }
+
+    for (auto& delegate : _delegates) {
+        if (HdMayaSceneDelegate* mayaScene = dynamic_cast<HdMayaSceneDelegate*>(delegate.get())) {
+            SdfPath cameraId = mayaScene->SetCameraViewport(_camPath, _viewport);
+
+            // Aspect ratio and film fit follow the viewport, which changes between renders
+#if HD_API_VERSION >= 43
+            mayaScene->GetChangeTracker().MarkSprimDirty(cameraId, HdCamera::DirtyParams);
+#else
+            mayaScene->GetChangeTracker().MarkSprimDirty(
+                cameraId, HdCamera::DirtyParams | HdCamera::DirtyProjMatrix);
+#endif
+            return cameraId;
+        }
+    }
+
+    return SdfPath();
+}
 
-    UsdPrim cameraPrim;
-    bool    isUsdCamera = false;
+UsdPrim RprUsdProductionRender::GetUsdCameraPrim() const
+{
+    if (!_usdCameraPath.IsEmpty()) {
+        UsdStageRefPtr usdStage = GetUsdStage();
+        return usdStage ? usdStage->GetPrimAtPath(_usdCameraPath) : UsdPrim();
+    }
 
     if (ProductionSettings::IsUSDCameraToUse()) {
-        cameraPrim = ProductionSettings::GetUsdCameraPrim();
-        isUsdCamera = cameraPrim.IsValid();
+        return ProductionSettings::GetUsdCameraPrim();
+    }
+
+    return UsdPrim();
+}
+
+MStatus RprUsdProductionRender::RenderCameras(
+    unsigned int                 width,
+    unsigned int                 height,
+    MString                      newLayerName,
+    const std::vector<MDagPath>& cameraPaths,
+    const SdfPathVector&         usdCameraPaths)
+{
+    // Sequence mode keeps the scene synced between cameras, only camera matrices change
+    const bool isSequenceMode = _isSequenceMode;
+    if (!isSequenceMode) {
+        BeginSequence();
+    }
+
+    // Camera renders go one after another, each has to finish before the camera switch. Every
+    // camera after the first restarts the renderer on the synced scene, its buffer reports the
+    // previous camera as converged until the restart is picked up.
+    MStatus status = MStatus::kSuccess;
+    for (const MDagPath& cameraPath : cameraPaths) {
+        SetUsdCamera(SdfPath());
+        status = StartRender(width, height, newLayerName, cameraPath, true);
+        if (status != MStatus::kSuccess || _isCancelled) {
+            break;
+        }
+    }
+
+    if (status == MStatus::kSuccess && !_isCancelled) {
+        for (const SdfPath& usdCameraPath : usdCameraPaths) {
+            SetUsdCamera(usdCameraPath);
+            status = StartRender(width, height, newLayerName, MDagPath(), true);
+            if (status != MStatus::kSuccess || _isCancelled) {
+                break;
+            }
+        }
     }
 
+    SetUsdCamera(SdfPath());
+
+    if (!isSequenceMode) {
+        EndSequence();
+    }
+
+    return status;
+}
+
+void RprUsdProductionRender::ComputeCameraMatrices(
+    GfMatrix4d& viewMatrix,
+    GfMatrix4d& projectionMatrix)
+{
+    UsdPrim cameraPrim = GetUsdCameraPrim();
+    bool    isUsdCamera = cameraPrim.IsValid();
+
     if (!isUsdCamera) {
         MFnCamera fnCamera(_camPath.node());
 
@@ -549,41 +1792,145 @@ MStatus RprUsdProductionRender::Render()
         projMatrix[2][2] = -projMatrix[2][2];
         projMatrix[3][2] = -projMatrix[3][2];
 
-        MMatrix viewMatrix = MFnTransform(_camPath.transform()).transformationMatrix().inverse();
+        MMatrix mayaViewMatrix
+            = MFnTransform(_camPath.transform()).transformationMatrix().inverse();
 
-        _taskController->SetFreeCameraMatrices(
-            GetGfMatrixFromMaya(viewMatrix), GetGfMatrixFromMaya(projMatrix));
+        viewMatrix = GetGfMatrixFromMaya(mayaViewMatrix);
+        projectionMatrix = GetGfMatrixFromMaya(projMatrix);
     } else {
         UsdGeomCamera usdGeomCamera(cameraPrim);
 
         GfCamera camera = usdGeomCamera.GetCamera(GetMayaUsdProxyShapeBase()->getTime());
 
-        GfMatrix4d projectionMatrix = camera.GetFrustum().ComputeProjectionMatrix();
-        GfMatrix4d viewMatrix = camera.GetFrustum().ComputeViewMatrix();
+        projectionMatrix = camera.GetFrustum().ComputeProjectionMatrix();
+        viewMatrix = camera.GetFrustum().ComputeViewMatrix();
+    }
 
-        _taskController->SetFreeCameraMatrices(viewMatrix, projectionMatrix);
+    if (HasRenderRegion()) {
+        projectionMatrix *= ComputeRegionCropMatrix();
     }
+}
 
-    _taskController->SetEnablePresentation(false);
+double RprUsdProductionRender::GetPercentDone()
+{
+    VtDictionary dict = _GetRenderDelegate()->GetRenderStats();
+    auto         percentDoneIt = dict.find("percentDone");
+    if (percentDoneIt != dict.end() && percentDoneIt->second.IsHolding<double>()) {
+        return percentDoneIt->second.UncheckedGet<double>();
+    }
 
-    _taskController->SetRenderParams(params);
-    if (!params.camera.IsEmpty())
-        _taskController->SetCameraPath(params.camera);
+    return -1.0;
+}
 
-    // Default color in usdview.
-    _taskController->SetEnableSelection(false);
+void RprUsdProductionRender::MarkRestarted()
+{
+    _isAwaitingRestart = true;
+    _restartSamples = GetCompletedSamples();
+    _restartPercentDone = GetPercentDone();
+    _restartTime = GetCurrentChronoTime();
+}
 
-    _taskController->SetCollection(_renderCollection);
+bool RprUsdProductionRender::IsRenderConverged(HdRenderBuffer* bufferPtr)
+{
+    if (!bufferPtr->IsConverged()) {
+        _isAwaitingRestart = false;
+        return false;
+    }
 
-    renderFrame(true);
+    if (!_isAwaitingRestart) {
+        return true;
+    }
+
+    // Buffer reports the state of the render before the restart until the renderer picks it up
+    const bool progressChanged = GetCompletedSamples() != _restartSamples
+        || GetPercentDone() != _restartPercentDone;
+    if (!progressChanged
+        && TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), _restartTime)
+            < kRestartTimeoutMs) {
+        return false;
+    }
 
-    OutputHardwareSetupAndSyncTime();
+    _isAwaitingRestart = false;
+    return true;
+}
 
-    for (auto& it : _delegates) {
-        it->PostFrame();
+int64_t RprUsdProductionRender::GetCompletedSamples()
+{
+    // Stats keys differ between hdRPR versions, so the sample count is optional
+    VtDictionary dict = _GetRenderDelegate()->GetRenderStats();
+    auto         samplesIt = dict.find("numCompletedSamples");
+    if (samplesIt != dict.end()) {
+        if (samplesIt->second.IsHolding<int>()) {
+            return samplesIt->second.UncheckedGet<int>();
+        } else if (samplesIt->second.IsHolding<unsigned int>()) {
+            return samplesIt->second.UncheckedGet<unsigned int>();
+        } else if (samplesIt->second.IsHolding<double>()) {
+            return (int64_t)samplesIt->second.UncheckedGet<double>();
+        }
     }
 
-    return MStatus::kSuccess;
+    return -1;
+}
+
+void RprUsdProductionRender::WriteRenderStats(TimePoint stopTime)
+{
+    std::string statsFilePath = ProductionSettings::GetStatsFilePath();
+    if (statsFilePath.empty()) {
+        return;
+    }
+
+    FrameRenderStats stats;
+    stats.frame = MAnimControl::currentTime().value();
+
+    stats.camera = GetCameraName();
+
+    stats.syncTimeMs
+        = (int64_t)TimeDiffChrono<std::chrono::milliseconds>(_syncFinishedTime, _startRenderTime);
+    stats.firstIterationTimeMs = _firstIterationTimeMs;
+    stats.totalTimeMs
+        = (int64_t)TimeDiffChrono<std::chrono::milliseconds>(stopTime, _startRenderTime);
+
+    if (_isConverged) {
+        stats.timeToConvergeMs
+            = (int64_t)TimeDiffChrono<std::chrono::milliseconds>(stopTime, _syncFinishedTime);
+    }
+
+    SampleMemoryUsage();
+
+    stats.samples = GetCompletedSamples();
+    stats.peakMemoryBytes = _framePeakMemoryBytes;
+    stats.memoryDeltaBytes
+        = int64_t(RenderStatsWriter::GetMemoryUsage()) - int64_t(_frameStartMemoryBytes);
+    stats.settingsHash = _settingsHash;
+    stats.converged = _isConverged;
+    stats.cancelled = _isCancelled;
+
+    if (!RenderStatsWriter::Append(statsFilePath, stats)) {
+        OutputWarningToMayaConsoleCommon(
+            MString("Render statistics could not be written to ") + statsFilePath.c_str());
+    }
+}
+
+void RprUsdProductionRender::SampleMemoryUsage()
+{
+    _framePeakMemoryBytes = std::max(_framePeakMemoryBytes, RenderStatsWriter::GetMemoryUsage());
+}
+
+GfMatrix4d RprUsdProductionRender::ComputeRegionCropMatrix() const
+{
+    // Scale and shift clip space, so the region covers the whole [-1, 1] NDC range
+    const double scaleX = double(_imageWidth) / _renderRegion[2];
+    const double scaleY = double(_imageHeight) / _renderRegion[3];
+    const double centerX = (2.0 * _renderRegion[0] + _renderRegion[2]) / _imageWidth - 1.0;
+    const double centerY = (2.0 * _renderRegion[1] + _renderRegion[3]) / _imageHeight - 1.0;
+
+    // clang-format off
+    return GfMatrix4d(
+        scaleX,            0.0,               0.0, 0.0,
+        0.0,               scaleY,            0.0, 0.0,
+        0.0,               0.0,               1.0, 0.0,
+        -scaleX * centerX, -scaleY * centerY, 0.0, 1.0);
+    // clang-format on
 }
 
 void RprUsdProductionRender::OutputHardwareSetupAndSyncTime()
@@ -613,8 +1960,9 @@ void RprUsdProductionRender::OutputHardwareSetupAndSyncTime()
         MString("CPU for rendering: threadCount= ") + std::to_string(threadCount).c_str());
 
     // after renderFrame call we can say how much time sync process took
+    _syncFinishedTime = GetCurrentChronoTime();
     unsigned long totalSyncTimeMiliseconds
-        = TimeDiffChrono<std::chrono::milliseconds>(GetCurrentChronoTime(), _startRenderTime);
+        = TimeDiffChrono<std::chrono::milliseconds>(_syncFinishedTime, _startRenderTime);
     OutputInfoToMayaConsole("Sync Time", totalSyncTimeMiliseconds);
 }
 
@@ -660,6 +2008,12 @@ void RprUsdProductionRender::RegisterRenderer(
 		renderer - rendererUIName $currentRendererName
 			 - renderProcedure "rprUsdRenderCmd" 
  		         - renderSequenceProcedure "rprUsdRenderSequence" 
+			 - renderRegionProcedure "rprUsdRenderRegion"
+			 - iprRenderProcedure "rprUsdIprRender"
+			 - startIprRenderProcedure "rprUsdStartIprRender"
+			 - stopIprRenderProcedure "rprUsdStopIprRender"
+			 - pauseIprRenderProcedure "rprUsdPauseIprRender"
+			 - isRunningIprProcedure "rprUsdIsRunningIpr"
 			rprUsdRender;
 
 		renderer - edit - addGlobalsNode "RprUsdGlobals" rprUsdRender;
@@ -700,12 +2054,95 @@ void RprUsdProductionRender::RegisterRenderer(
 		return $result;
 	}
 
+	global proc rprUsdRenderRegion(string $editor)
+	{
+		string $camera = `renderWindowEditor -q -currentCamera $editor`;
+		int $width = `getAttr defaultResolution.width`;
+		int $height = `getAttr defaultResolution.height`;
+
+		// region is taken from the Render View marquee
+		string $cmd = "rprUsdRender -w " + $width + " -h " + $height + " -cam " + $camera + " -renderViewRegion";
+		eval($cmd);
+	}
+
+	global proc rprUsdIprRender(int $width, int $height, int $doShadows, int $doGlow, string $camera, string $options)
+	{
+		rprUsdRender -ipr -w $width -h $height -cam $camera;
+	}
+
+	global proc rprUsdStartIprRender(string $editor, int $width, int $height, string $camera)
+	{
+		rprUsdRender -ipr -w $width -h $height -cam $camera;
+	}
+
+	global proc rprUsdStopIprRender()
+	{
+		rprUsdRender -stopIpr;
+	}
+
+	global proc rprUsdPauseIprRender(string $editor, int $pause)
+	{
+		rprUsdRender -pauseIpr $pause;
+	}
+
+	global proc int rprUsdIsRunningIpr()
+	{
+		return `rprUsdRender -isIprRunning`;
+	}
+
 	global proc createRprUsdRenderConfigTab()
 	{
 		columnLayout -w 375 -adjustableColumn true rprmayausd_configcolumn;
 
 		button -label "Configure Hardware" -command "onConfigureGPU";
 
+		frameLayout -label "Render Delegate" -cll true -cl false;
+			attrControlGrp -label "Keep Alive Timeout (sec)" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_delegateIdleTimeout";
+			text -label "Idle renderer is kept between renders to start them faster, 0 to disable" -align "left";
+			attrControlGrp -label "CPU Thread Limit" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_cpuThreadLimit";
+			text -label "CPU threads the renderer may use, 0 for all of them" -align "left";
+		setParent ..; // frameLayout
+
+		frameLayout -label "Scene" -cll true -cl false;
+			attrControlGrp -label "Reuse Viewport Scene" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_reuseViewportScene";
+			text -label "Render the scene already synced by the hdRPR viewport instead of syncing it again" -align "left";
+			attrControlGrp -label "USD Proxy Shape" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_usdProxyShape";
+			text -label "Proxy shape of the rendered USD stage, the first one is used if empty" -align "left";
+		setParent ..; // frameLayout
+
+		frameLayout -label "Output AOVs" -cll true -cl false;
+			attrControlGrp -label "AOVs (multi-layer EXR)" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_aovs";
+			text -label "Space separated, e.g.: depth normal albedo primId instanceId variance lightGroup0" -align "left";
+			text -label "primId and instanceId are written as UINT channels, no prim is 4294967295" -align "left";
+		setParent ..; // frameLayout
+
+		frameLayout -label "Cancel" -cll true -cl false;
+			attrControlGrp -label "Save Cancelled Frames" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_saveCancelledFrames";
+			text -label "Partial image of a cancelled render is saved to disk" -align "left";
+		setParent ..; // frameLayout
+
+		frameLayout -label "Statistics" -cll true -cl false;
+			attrControlGrp -label "Statistics File (JSON lines)" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_statsFile";
+			text -label "Per-frame render statistics are appended to the file, leave empty to disable" -align "left";
+		setParent ..; // frameLayout
+
+		frameLayout -label "Sequence" -cll true -cl false;
+			attrControlGrp -label "Skip Existing Frames" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_skipExistingFrames";
+			attrControlGrp -label "Write Checksums" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_writeChecksums";
+			text -label "Frames with a valid image on disk are not rendered again, checksums also catch truncated files" -align "left";
+			attrControlGrp -label "Temporal Sample Budget" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_temporalSampleBudget";
+			attrControlGrp -label "Min Sample Budget" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_sampleBudgetMin";
+			attrControlGrp -label "Max Sample Budget" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_sampleBudgetMax";
+			text -label "Max samples of a frame follow the samples the previous frame needed to reach the noise threshold" -align "left";
+			text -label "Frames stopped by the budget before the threshold are rendered again with a higher one, 0 takes min and max samples" -align "left";
+		setParent ..; // frameLayout
+
+		frameLayout -label "Tiled Rendering" -cll true -cl false;
+			attrControlGrp -label "Tile Size" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_tileSize";
+			text -label "Images larger than the tile are rendered tile by tile directly to EXR, 0 to disable" -align "left";
+			text -label "Denoising is turned off for tiled render, denoised tiles would not match at the seams" -align "left";
+		setParent ..; // frameLayout
+
 		setParent ..;
 	}
 
@@ -794,6 +2231,12 @@ void RprUsdProductionRender::RegisterRenderer(
 
 		setParent ..; // frameLayout
 
+		frameLayout - label "Motion Blur" - cll true - cl false;
+			attrControlGrp -label "Shutter Open (frames)" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_motionSampleStart";
+			attrControlGrp -label "Shutter Close (frames)" -attribute "defaultRenderGlobals.HdRprPlugin_Prod_Static_motionSampleEnd";
+			text -label "Maya camera and objects are sampled over the shutter, USD cameras use their own shutter" -align "left";
+		setParent ..; // frameLayout
+
 		{CAMERA_CONTROLS_CREATION_CMDS}
 
 		OnIsUseUsdCameraChanged();
@@ -970,6 +2413,16 @@ void RprUsdProductionRender::RegisterRenderer(
 		}
 	}
 
+	global proc HdRpr_setUSDCameras(string $cameraNames[])
+	{
+		HdRpr_clearUSDCameras();
+
+		for ($cameraName in $cameraNames)
+		{
+			HdRpr_AddUsdCamera($cameraName);
+		}
+	}
+
 	global proc string GetCurrentUsdCamera()
 	{
 		return `getAttr defaultRenderGlobals.HdRprPlugin_Prod_Static_usdCameraSelected`;
@@ -1023,13 +2476,28 @@ void RprUsdProductionRender::RegisterRenderer(
 			return 1;
 		}
 
-		string $extraOptions = "-wfi";
+		string $extraOptions = "-wfi -sequenceFrame";
+
+		// Resume mode, frames already on disk are validated and skipped
+		if (`getAttr defaultRenderGlobals.HdRprPlugin_Prod_Static_skipExistingFrames`)
+		{
+			$extraOptions += " -skipExisting";
+		}
+
+		int $headless = `about -batch`;
+		if ($headless)
+		{
+			$extraOptions += " -headless";
+		}
 
 		int $numberOfFrames = ceil(($endFrame - $startFrame + 1.0) / $byFrame);
 		int $curFrame = 1;
 
 		string $outputFormatString = "Frame to render: ^1s (^2s/^3s)  Camera: ^4s  Layer: ^5s\n";
 
+		// Keep Hydra scene alive between frames, only dirty prims are synced for each next frame
+		rprUsdRender -sequenceBegin;
+
 		for ($time = $startFrame; $time <= $endFrame; $time += $byFrame)
 		{
 			currentTime $time;
@@ -1045,9 +2513,13 @@ void RprUsdProductionRender::RegisterRenderer(
 
 				float $startTime = `timerX`;
 
-				eval($cmd);
+				if (catch(eval($cmd)))
+				{
+					rprUsdRender -sequenceEnd;
+					return 1;
+				}
 
-				if ($saveToRenderView == "all" || $saveToRenderView == $cam)
+				if (!$headless && ($saveToRenderView == "all" || $saveToRenderView == $cam))
 				{
 					float $renderTime = `timerX -startTime $startTime`;
 					string $windowCaption = renderWindowCaption("", $renderTime);
@@ -1060,6 +2532,8 @@ void RprUsdProductionRender::RegisterRenderer(
 			$curFrame += 1;
 		}
 
+		rprUsdRender -sequenceEnd;
+
 		return 0;
 	}
 
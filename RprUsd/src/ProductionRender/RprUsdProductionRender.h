@@ -18,6 +18,10 @@
 
 #include "../defaultLightDelegate.h"
 
+#include <mayaUsd/nodes/proxyShapeBase.h>
+
+#include <pxr/base/gf/matrix4d.h>
+#include <pxr/base/gf/vec4i.h>
 #include <pxr/base/tf/singleton.h>
 #include <pxr/imaging/hd/driver.h>
 #include <pxr/imaging/hd/engine.h>
@@ -29,9 +33,17 @@
 
 #pragma warning(pop)
 
+#include "ImageWriter.h"
+#include "RenderDelegatePool.h"
 #include "RenderProgressBars.h"
+#include "TemporalSampleBudget.h"
 
 #include <maya/MMessage.h>
+#include <maya/MNodeMessage.h>
+#include <maya/MRenderView.h>
+#include <maya/MStringArray.h>
+
+#include <unordered_map>
 
 PXR_NAMESPACE_OPEN_SCOPE
 
@@ -53,6 +65,51 @@ public:
         bool         synchronousRender);
     void StopRender();
 
+    /* Sequence mode keeps the render index, task controller and delegates alive between
+     * StartRender calls, so every next frame only re-syncs prims marked dirty in the change tracker.
+     */
+    void BeginSequence();
+    void EndSequence();
+    bool IsSequenceMode() const { return _isSequenceMode; }
+
+    /** Wait until queued images are written and return the images of the frames rendered since the
+     * last flush. Return false if any of them could not be saved. */
+    bool FlushImages(MStringArray& imagePaths);
+
+    /** Interactive render to Render View. Scene stays synced, changes of the scene, camera and
+     * render settings are synced incrementally and restart progressive rendering.
+     */
+    MStatus StartIpr(unsigned int width, unsigned int height, MDagPath cameraPath);
+    void    StopIpr();
+    void    PauseIpr(bool pause);
+    bool    IsIprRunning() const { return _isIprMode; }
+
+    /** Headless mode doesn't touch Render View and progress windows (mayabatch, mayapy).
+     * Progress goes to the log and images are written directly to disk.
+     */
+    void SetHeadless(bool headless) { _isHeadless = headless; }
+
+    /** Render only the region (left, bottom, width, height) of the image, pixels outside are
+     * taken from the last full frame. Empty region renders the full frame.
+     */
+    void SetRenderRegion(const GfVec4i& region) { _renderRegion = region; }
+
+    /** Render the USD camera instead of the Maya one, empty path uses the render settings. */
+    void SetUsdCamera(const SdfPath& usdCameraPath) { _usdCameraPath = usdCameraPath; }
+
+    /** Render several cameras of the current frame back to back with one scene sync.
+     * Blocks until all of them are rendered.
+     */
+    MStatus RenderCameras(
+        unsigned int                 width,
+        unsigned int                 height,
+        MString                      newLayerName,
+        const std::vector<MDagPath>& cameraPaths,
+        const SdfPathVector&         usdCameraPaths);
+
+    /** Don't render the frame if a valid image is already on disk. */
+    void SetSkipExisting(bool skipExisting) { _skipExisting = skipExisting; }
+
     bool IsCancelled() const { return _isCancelled; }
 
     static void Initialize();
@@ -60,21 +117,58 @@ public:
 
 private:
     bool InitHydraResources();
+    bool InitSharedHydraResources();
+    void OnSharedRenderIndexRevoked();
     void ClearHydraResources();
+    void UpdateHydraResourcesTime();
 
     void    ApplySettings();
-    MStatus Render();
-
-    void SaveToFile();
+    void    SetupRenderOutputs();
+    MStatus Render(bool outputSyncTime = true);
+    void    ComputeCameraMatrices(GfMatrix4d& viewMatrix, GfMatrix4d& projectionMatrix);
+    UsdPrim GetUsdCameraPrim() const;
+    SdfPath GetMotionBlurCameraId();
+
+    /** Tiles are rendered one after another by the same timer or sync loop as a frame. */
+    struct TiledRender;
+    bool BeginTiledRender(unsigned int tileSize);
+    void StartTile();
+    bool ProcessTile();
+    bool WriteTile();
+    void EndTiledRender();
+
+    MString GetImagePath() const;
+    void    SaveToFile();
+    bool SaveToFileAsync(const MString& fullPath);
+    void CompositeRegionIntoLastFrame(std::vector<ImageWriter::Layer>& layers);
+    void ReleaseLastFrame();
+    std::string GetCameraName() const;
+
+    bool       HasRenderRegion() const { return _renderRegion[2] > 0 && _renderRegion[3] > 0; }
+    GfMatrix4d ComputeRegionCropMatrix() const;
 
     HdRenderDelegate* _GetRenderDelegate();
 
-    void RefreshRenderView();
+    /** Push the color buffer to Render View. Progressive refresh of a large image pushes only
+     * the next band of rows, fullRefresh pushes the whole image. */
+    void RefreshRenderView(bool fullRefresh = false);
+
+    /** Check convergence and cancellation, refresh Render View if refreshPreview is set.
+     * Return false once the render is stopped. */
+    bool RefreshAndCheck(bool refreshPreview);
+
+    void        CheckIprChanges();
+    static void IprSettingsChangedCallback(
+        MNodeMessage::AttributeMessage msg,
+        MPlug&                         plug,
+        MPlug&                         otherPlug,
+        void*                          pClientData);
 
-    bool RefreshAndCheck();
+    static void SceneChangedCallback(void* pClientData);
 
     static void RPRMainThreadTimerEventCallback(float, float, void* pClientData);
     bool        ProcessTimerMessage();
+    void        UpdateProgress();
 
     void ProcessSyncRender(float refreshRate);
 
@@ -82,26 +176,79 @@ private:
     static void UnregisterRenderer();
 
     void OutputHardwareSetupAndSyncTime();
+    void WriteRenderStats(TimePoint stopTime);
+    void SampleMemoryUsage();
+    int64_t GetCompletedSamples();
+    double  GetPercentDone();
+
+    /** Remember the progress at the renderer restart. Converged state of the buffer is not
+     * trusted until the progress changes, before that it may belong to the previous render. */
+    void MarkRestarted();
+    bool IsRenderConverged(HdRenderBuffer* bufferPtr);
 
 private:
     bool _renderIsStarted;
     bool _initialized;
 
     bool _hasDefaultLighting;
+    bool _hasMotionSamples = false;
 
     bool _isConverged;
     bool _isCancelled;
 
-    GfVec4d  _viewport;
+    bool _isSequenceMode;
+    bool _isSharedRenderIndex = false;
+    bool _isTiledRender = false;
+    bool _isHeadless;
+    bool _skipExisting = false;
+    int  _lastReportedProgress;
+
+    bool         _isIprMode = false;
+    bool         _isIprPaused = false;
+    bool         _iprSettingsDirty = false;
+    MCallbackId  _iprSettingsCallbackId = 0;
+    unsigned int _lastSceneStateVersion = 0;
+    GfMatrix4d   _lastViewMatrix;
+    GfMatrix4d   _lastProjectionMatrix;
+
+    TimePoint     _lastPreviewRefreshTime;
+    unsigned long _previewRefreshIntervalMs;
+
+    GfVec4d      _viewport;
+    GfVec4i      _renderRegion;
+    unsigned int _imageWidth = 0;
+    unsigned int _imageHeight = 0;
+
+    // Last interactive full frame, region renders of the same frame, camera and resolution are
+    // composited into it. Released by any other kind of render and by scene change.
+    std::vector<ImageWriter::Layer> _lastFrameLayers;
+    unsigned int                    _lastFrameWidth = 0;
+    unsigned int                    _lastFrameHeight = 0;
+    double                          _lastFrameTime = 0.0;
+    std::string                     _lastFrameCamera;
+
     MDagPath _camPath;
+    SdfPath  _usdCameraPath;
+
+    TfTokenVector _aovs;
 
     MString _oldLayerName;
     MString _newLayerName;
 
     MCallbackId _callbackTimerId;
+    MCallbackId _beforeNewSceneCallbackId = 0;
+    MCallbackId _beforeOpenSceneCallbackId = 0;
 
     std::unique_ptr<RenderProgressBars> _renderProgressBars;
 
+    // Samples of the image pushed last time and the first row of the next progressive band
+    int64_t      _renderViewSamples = -1;
+    unsigned int _renderViewNextRow = 0;
+
+    std::unique_ptr<ImageWriter> _imageWriter;
+    MStringArray                 _unflushedImagePaths;
+    std::unique_ptr<TiledRender> _tiledRender;
+
     HdRprimCollection _renderCollection
     {
         HdTokens->geometry,
@@ -127,9 +274,27 @@ private:
     HdxTaskController*                        _taskController = nullptr;
     HdRenderIndex*                            _renderIndex = nullptr;
     std::unique_ptr<MtohDefaultLightDelegate> _defaultLightDelegate = nullptr;
+    RenderDelegatePool                        _delegatePool;
+    // Budget history of every camera of the sequence, the one of the current render
+    std::unordered_map<std::string, TemporalSampleBudget> _sampleBudgets;
+    TemporalSampleBudget*                                 _sampleBudget = nullptr;
+
+    UsdImagingDelegate*    _pImagingDelegate = nullptr;
+    MayaUsdProxyShapeBase* _pProxyShapeBase = nullptr;
 
     TimePoint _startRenderTime;
+    TimePoint _syncFinishedTime;
     bool      _additionalStatsWasOutput;
+    int64_t   _firstIterationTimeMs = -1;
+    uint64_t  _frameStartMemoryBytes = 0;
+    uint64_t  _framePeakMemoryBytes = 0;
+    size_t    _settingsHash = 0;
+
+    bool      _isSampleBudgetApplied = false;
+    bool      _isAwaitingRestart = false;
+    int64_t   _restartSamples = -1;
+    double    _restartPercentDone = -1.0;
+    TimePoint _restartTime;
 };
 
 PXR_NAMESPACE_CLOSE_SCOPE
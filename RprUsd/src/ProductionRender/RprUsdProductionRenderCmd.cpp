@@ -15,6 +15,7 @@
 
 #include "ProductionSettings.h"
 #include "RprUsdProductionRender.h"
+#include "common.h"
 #include "maya/MDagPath.h"
 #include "maya/MFnCamera.h"
 #include "maya/MFnRenderLayer.h"
@@ -43,6 +44,7 @@
 #include <pxr/imaging/hdx/tokens.h>
 #include <pxr/imaging/hgi/hgi.h>
 #include <pxr/imaging/hgi/tokens.h>
+#include <pxr/usd/usdGeom/camera.h>
 
 #pragma warning(pop)
 
@@ -67,7 +69,11 @@ MSyntax RprUsdProductionRenderCmd::newSyntax()
 {
     MSyntax syntax;
 
+    // Several cameras are rendered back to back against the same synced scene
     CHECK_MSTATUS(syntax.addFlag(kCameraFlag, kCameraFlagLong, MSyntax::kString));
+    CHECK_MSTATUS(syntax.makeFlagMultiUse(kCameraFlag));
+    CHECK_MSTATUS(syntax.addFlag(kUsdCameraFlag, kUsdCameraFlagLong, MSyntax::kString));
+    CHECK_MSTATUS(syntax.makeFlagMultiUse(kUsdCameraFlag));
     CHECK_MSTATUS(syntax.addFlag(kRenderLayerFlag, kRenderLayerFlagLong, MSyntax::kString));
     CHECK_MSTATUS(syntax.addFlag(kWidthFlag, kWidthFlagLong, MSyntax::kLong));
     CHECK_MSTATUS(syntax.addFlag(kHeightFlag, kHeightFlagLong, MSyntax::kLong));
@@ -76,6 +82,28 @@ MSyntax RprUsdProductionRenderCmd::newSyntax()
 
     CHECK_MSTATUS(syntax.addFlag(kWaitForIt, kWaitForItLong, MSyntax::kNoArg));
 
+    CHECK_MSTATUS(syntax.addFlag(kHeadlessFlag, kHeadlessFlagLong, MSyntax::kNoArg));
+
+    CHECK_MSTATUS(syntax.addFlag(
+        kRegionFlag,
+        kRegionFlagLong,
+        MSyntax::kLong,
+        MSyntax::kLong,
+        MSyntax::kLong,
+        MSyntax::kLong));
+    CHECK_MSTATUS(syntax.addFlag(kRenderViewRegionFlag, kRenderViewRegionFlagLong, MSyntax::kNoArg));
+
+    CHECK_MSTATUS(syntax.addFlag(kSequenceBeginFlag, kSequenceBeginFlagLong, MSyntax::kNoArg));
+    CHECK_MSTATUS(syntax.addFlag(kSequenceEndFlag, kSequenceEndFlagLong, MSyntax::kNoArg));
+    CHECK_MSTATUS(syntax.addFlag(kFlushImagesFlag, kFlushImagesFlagLong, MSyntax::kNoArg));
+    CHECK_MSTATUS(syntax.addFlag(kSequenceFrameFlag, kSequenceFrameFlagLong, MSyntax::kNoArg));
+    CHECK_MSTATUS(syntax.addFlag(kSkipExistingFlag, kSkipExistingFlagLong, MSyntax::kNoArg));
+
+    CHECK_MSTATUS(syntax.addFlag(kIprFlag, kIprFlagLong, MSyntax::kNoArg));
+    CHECK_MSTATUS(syntax.addFlag(kStopIprFlag, kStopIprFlagLong, MSyntax::kNoArg));
+    CHECK_MSTATUS(syntax.addFlag(kPauseIprFlag, kPauseIprFlagLong, MSyntax::kBoolean));
+    CHECK_MSTATUS(syntax.addFlag(kIsIprRunningFlag, kIsIprRunningFlagLong, MSyntax::kNoArg));
+
     CHECK_MSTATUS(
         syntax.addFlag(kUSDCameraListRefreshFlag, kUSDCameraListRefreshFlagLong, MSyntax::kNoArg));
 
@@ -101,13 +129,52 @@ MStatus getDimensions(const MArgDatabase& argData, unsigned int& width, unsigned
     return MS::kSuccess;
 }
 
-MStatus getCameraPath(const MArgDatabase& argData, MDagPath& cameraPath)
+MStatus getRegion(
+    const MArgDatabase& argData,
+    unsigned int        width,
+    unsigned int        height,
+    GfVec4i&            region)
 {
-    // Get camera name argument.
-    MString cameraName;
-    if (argData.isFlagSet(kCameraFlag))
-        argData.getFlagArgument(kCameraFlag, 0, cameraName);
+    region = GfVec4i(0, 0, 0, 0);
+
+    int left = 0, bottom = 0, regionWidth = 0, regionHeight = 0;
+
+    if (argData.isFlagSet(kRegionFlag)) {
+        argData.getFlagArgument(kRegionFlag, 0, left);
+        argData.getFlagArgument(kRegionFlag, 1, bottom);
+        argData.getFlagArgument(kRegionFlag, 2, regionWidth);
+        argData.getFlagArgument(kRegionFlag, 3, regionHeight);
+    } else if (argData.isFlagSet(kRenderViewRegionFlag)) {
+        unsigned int regionLeft, regionRight, regionBottom, regionTop;
+        if (MRenderView::getRenderRegion(regionLeft, regionRight, regionBottom, regionTop)
+            != MS::kSuccess) {
+            return MS::kSuccess;
+        }
+
+        left = regionLeft;
+        bottom = regionBottom;
+        regionWidth = regionRight - regionLeft + 1;
+        regionHeight = regionTop - regionBottom + 1;
+    } else {
+        return MS::kSuccess;
+    }
+
+    if (left < 0 || bottom < 0 || regionWidth <= 0 || regionHeight <= 0
+        || unsigned(left + regionWidth) > width || unsigned(bottom + regionHeight) > height) {
+        MGlobal::displayError("Invalid render region");
+        return MS::kFailure;
+    }
 
+    // Full frame region is the regular render
+    if (unsigned(regionWidth) != width || unsigned(regionHeight) != height) {
+        region = GfVec4i(left, bottom, regionWidth, regionHeight);
+    }
+
+    return MS::kSuccess;
+}
+
+MStatus getCameraPath(const MString& cameraName, MDagPath& cameraPath)
+{
     // Get the camera scene DAG path.
     MSelectionList sList;
     sList.add(cameraName);
@@ -128,6 +195,45 @@ MStatus getCameraPath(const MArgDatabase& argData, MDagPath& cameraPath)
     return MS::kSuccess;
 }
 
+MStatus getCameraPaths(
+    const MArgDatabase&    argData,
+    std::vector<MDagPath>& cameraPaths,
+    SdfPathVector&         usdCameraPaths)
+{
+    for (unsigned int i = 0; i < argData.numberOfFlagUses(kCameraFlag); ++i) {
+        MArgList argList;
+        argData.getFlagArgumentList(kCameraFlag, i, argList);
+
+        MDagPath cameraPath;
+        if (getCameraPath(argList.asString(0), cameraPath) != MS::kSuccess) {
+            return MS::kFailure;
+        }
+        cameraPaths.push_back(cameraPath);
+    }
+
+    UsdStageRefPtr usdStage = GetUsdStage();
+
+    for (unsigned int i = 0; i < argData.numberOfFlagUses(kUsdCameraFlag); ++i) {
+        MArgList argList;
+        argData.getFlagArgumentList(kUsdCameraFlag, i, argList);
+
+        SdfPath usdCameraPath(argList.asString(0).asChar());
+        if (!usdStage || !usdCameraPath.IsAbsolutePath()
+            || !UsdGeomCamera(usdStage->GetPrimAtPath(usdCameraPath))) {
+            MGlobal::displayError("Invalid USD camera");
+            return MS::kFailure;
+        }
+        usdCameraPaths.push_back(usdCameraPath);
+    }
+
+    if (cameraPaths.empty() && usdCameraPaths.empty()) {
+        MGlobal::displayError("Invalid camera");
+        return MS::kFailure;
+    }
+
+    return MS::kSuccess;
+}
+
 // -----------------------------------------------------------------------------
 MStatus RprUsdProductionRenderCmd::doIt(const MArgList& args)
 {
@@ -140,6 +246,57 @@ MStatus RprUsdProductionRenderCmd::doIt(const MArgList& args)
         return MStatus::kSuccess;
     }
 
+    if (argData.isFlagSet(kSequenceBeginFlag)) {
+        if (!s_productionRender) {
+            s_productionRender = std::make_unique<RprUsdProductionRender>();
+        }
+
+        s_productionRender->BeginSequence();
+        return MStatus::kSuccess;
+    }
+
+    if (argData.isFlagSet(kSequenceEndFlag)) {
+        if (s_productionRender) {
+            s_productionRender->EndSequence();
+        }
+
+        return MStatus::kSuccess;
+    }
+
+    if (argData.isFlagSet(kFlushImagesFlag)) {
+        MStringArray imagePaths;
+        if (s_productionRender && !s_productionRender->FlushImages(imagePaths)) {
+            return MStatus::kFailure;
+        }
+
+        setResult(imagePaths);
+        return MStatus::kSuccess;
+    }
+
+    if (argData.isFlagSet(kStopIprFlag)) {
+        if (s_productionRender) {
+            s_productionRender->StopIpr();
+        }
+
+        return MStatus::kSuccess;
+    }
+
+    if (argData.isFlagSet(kPauseIprFlag)) {
+        bool pause = false;
+        argData.getFlagArgument(kPauseIprFlag, 0, pause);
+
+        if (s_productionRender) {
+            s_productionRender->PauseIpr(pause);
+        }
+
+        return MStatus::kSuccess;
+    }
+
+    if (argData.isFlagSet(kIsIprRunningFlag)) {
+        setResult(s_productionRender && s_productionRender->IsIprRunning());
+        return MStatus::kSuccess;
+    }
+
     if (argData.isFlagSet(kWaitForItTwoStep) || argData.isFlagSet(kWaitForItTwoStepLong)) {
         s_waitForIt = true;
         return MS::kSuccess;
@@ -154,8 +311,14 @@ MStatus RprUsdProductionRenderCmd::doIt(const MArgList& args)
         return MStatus::kFailure;
     }
 
-    MDagPath camPath;
-    status = getCameraPath(argData, camPath);
+    GfVec4i region;
+    status = getRegion(argData, width, height, region);
+    if (status != MS::kSuccess)
+        return status;
+
+    std::vector<MDagPath> camPaths;
+    SdfPathVector         usdCamPaths;
+    status = getCameraPaths(argData, camPaths, usdCamPaths);
     if (status != MS::kSuccess)
         return status;
 
@@ -169,11 +332,48 @@ MStatus RprUsdProductionRenderCmd::doIt(const MArgList& args)
         s_productionRender = std::make_unique<RprUsdProductionRender>();
     }
 
+    if (argData.isFlagSet(kIprFlag)) {
+        if (camPaths.empty()) {
+            MGlobal::displayError("IPR needs a Maya camera");
+            return MS::kFailure;
+        }
+        return s_productionRender->StartIpr(width, height, camPaths[0]);
+    }
+
+    // Regular render replaces the running IPR
+    s_productionRender->StopIpr();
+
+    // Sequence script failed before -sequenceEnd, its synced scene is stale for this render
+    if (s_productionRender->IsSequenceMode() && !argData.isFlagSet(kSequenceFrameFlag)) {
+        MGlobal::displayWarning("[hdRPR] Unfinished sequence render is ended");
+        s_productionRender->EndSequence();
+    }
+
     s_waitForIt = s_waitForIt || argData.isFlagSet(kWaitForIt);
 
-    status = s_productionRender->StartRender(width, height, newLayerName, camPath, s_waitForIt);
+    s_productionRender->SetHeadless(
+        argData.isFlagSet(kHeadlessFlag) || MGlobal::mayaState() != MGlobal::kInteractive);
+    s_productionRender->SetRenderRegion(region);
+    s_productionRender->SetSkipExisting(argData.isFlagSet(kSkipExistingFlag));
+
+    if (camPaths.size() + usdCamPaths.size() > 1) {
+        status = s_productionRender->RenderCameras(
+            width, height, newLayerName, camPaths, usdCamPaths);
+    } else if (!usdCamPaths.empty()) {
+        s_productionRender->SetUsdCamera(usdCamPaths[0]);
+        status = s_productionRender->StartRender(
+            width, height, newLayerName, MDagPath(), s_waitForIt);
+    } else {
+        s_productionRender->SetUsdCamera(SdfPath());
+        status = s_productionRender->StartRender(
+            width, height, newLayerName, camPaths[0], s_waitForIt);
+    }
     s_waitForIt = false;
 
+    if (status != MS::kSuccess) {
+        return status;
+    }
+
     return !s_productionRender->IsCancelled() ? MS::kSuccess : MS::kFailure;
 }
 
@@ -25,6 +25,8 @@
 // Command arguments.
 #define kCameraFlag          "-cam"
 #define kCameraFlagLong      "-camera"
+#define kUsdCameraFlag       "-uc"
+#define kUsdCameraFlagLong   "-usdCamera"
 #define kRenderLayerFlag     "-l"
 #define kRenderLayerFlagLong "-layer"
 #define kWidthFlag           "-w"
@@ -35,9 +37,53 @@
 #define kWaitForIt     "-wfi"
 #define kWaitForItLong "-waitForIt"
 
+// Skip Render View and progress windows, report progress to the log and write images directly
+#define kHeadlessFlag     "-hl"
+#define kHeadlessFlagLong "-headless"
+
+// Render only a region: left bottom width height, in pixels from the bottom left corner
+#define kRegionFlag     "-rg"
+#define kRegionFlagLong "-region"
+
+// Render only the region selected with Render View marquee
+#define kRenderViewRegionFlag     "-rvr"
+#define kRenderViewRegionFlagLong "-renderViewRegion"
+
 #define kWaitForItTwoStep     "-wft"
 #define kWaitForItTwoStepLong "-waitForItTwo"
 
+// Sequence rendering. Hydra resources are kept alive between -sequenceBegin and -sequenceEnd
+#define kSequenceBeginFlag     "-sqb"
+#define kSequenceBeginFlagLong "-sequenceBegin"
+
+#define kSequenceEndFlag     "-sqe"
+#define kSequenceEndFlagLong "-sequenceEnd"
+
+// Wait until rendered images are on disk, fails if any of them could not be saved
+#define kFlushImagesFlag     "-fli"
+#define kFlushImagesFlagLong "-flushImages"
+
+// Frame of the sequence started with -sequenceBegin, any other render ends a stale sequence
+#define kSequenceFrameFlag     "-sqf"
+#define kSequenceFrameFlagLong "-sequenceFrame"
+
+// Don't render the frame if its image is already on disk and valid, used to resume sequences
+#define kSkipExistingFlag     "-se"
+#define kSkipExistingFlagLong "-skipExisting"
+
+// Interactive render to Render View, runs until -stopIpr
+#define kIprFlag     "-ipr"
+#define kIprFlagLong "-interactive"
+
+#define kStopIprFlag     "-sip"
+#define kStopIprFlagLong "-stopIpr"
+
+#define kPauseIprFlag     "-pip"
+#define kPauseIprFlagLong "-pauseIpr"
+
+#define kIsIprRunningFlag     "-iir"
+#define kIsIprRunningFlagLong "-isIprRunning"
+
 // Misc flag. Its not related to rendering itself
 #define kUSDCameraListRefreshFlag     "-ucr"
 #define kUSDCameraListRefreshFlagLong "-usdCameraListRefresh"
@@ -0,0 +1,154 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "TemporalSampleBudget.h"
+
+#include "ProductionSettings.h"
+
+#pragma warning(push, 0)
+
+#include <pxr/base/arch/hash.h>
+#include <pxr/base/tf/staticTokens.h>
+#include <pxr/imaging/hd/renderDelegate.h>
+
+#pragma warning(pop)
+
+#include <algorithm>
+#include <cmath>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+TF_DEFINE_PRIVATE_TOKENS(
+    _tokens,
+    ((maxSamples, "rpr:maxSamples"))((minAdaptiveSamples, "rpr:adaptiveSampling:minSamples"))(
+        (noiseThreshold, "rpr:adaptiveSampling:noiseTreshold")));
+
+// Budget over the samples of the previous frame, covers small changes between frames
+static const double kBudgetHeadroom = 1.25;
+
+namespace {
+
+double GetNumericSetting(HdRenderDelegate* renderDelegate, const TfToken& key)
+{
+    VtValue value = renderDelegate->GetRenderSetting(key);
+    if (value.IsHolding<int>()) {
+        return value.UncheckedGet<int>();
+    } else if (value.IsHolding<float>()) {
+        return value.UncheckedGet<float>();
+    } else if (value.IsHolding<double>()) {
+        return value.UncheckedGet<double>();
+    }
+
+    return 0.0;
+}
+
+// Value is set with the type the delegate already holds
+void SetNumericSetting(HdRenderDelegate* renderDelegate, const TfToken& key, double value)
+{
+    VtValue current = renderDelegate->GetRenderSetting(key);
+    if (current.IsHolding<int>()) {
+        ProductionSettings::ApplyOverride(renderDelegate, key, VtValue((int)value));
+    } else if (current.IsHolding<float>()) {
+        ProductionSettings::ApplyOverride(renderDelegate, key, VtValue((float)value));
+    } else if (current.IsHolding<double>()) {
+        ProductionSettings::ApplyOverride(renderDelegate, key, VtValue(value));
+    }
+}
+
+} // namespace
+
+void TemporalSampleBudget::Reset()
+{
+    _settingsHash = 0;
+    _budget = 0;
+    _lastSamples = -1;
+    _lastReachedThreshold = false;
+}
+
+size_t TemporalSampleBudget::Apply(
+    HdRenderDelegate* renderDelegate,
+    size_t            settingsHash,
+    int               minBudget,
+    int               maxBudget)
+{
+    // Artist changed the settings, history of the old ones doesn't apply
+    if (settingsHash != _settingsHash) {
+        Reset();
+        _settingsHash = settingsHash;
+    }
+
+    const int maxSamples = (int)GetNumericSetting(renderDelegate, _tokens->maxSamples);
+    const int minSamples = (int)GetNumericSetting(renderDelegate, _tokens->minAdaptiveSamples);
+    const double noiseThreshold = GetNumericSetting(renderDelegate, _tokens->noiseThreshold);
+
+    _maxBudget = maxBudget > 0 ? std::min(maxBudget, maxSamples) : maxSamples;
+    _minBudget = std::min(std::max(1, minBudget > 0 ? minBudget : minSamples), _maxBudget);
+    _noiseThreshold = noiseThreshold;
+
+    // Without adaptive sampling every frame takes all samples, there is nothing to predict
+    if (noiseThreshold <= 0.0 || maxSamples <= 0) {
+        _budget = maxSamples;
+        return settingsHash;
+    }
+
+    int budget;
+    if (_lastSamples < 0 || _budget <= 0) {
+        // First frame measures how many samples the shot needs
+        budget = _maxBudget;
+    } else if (_lastReachedThreshold) {
+        budget = (int)(_lastSamples * kBudgetHeadroom + 0.5);
+    } else {
+        // Previous frame ended at the max budget, it may have needed more
+        budget = _budget * 2;
+    }
+    _budget = std::max(_minBudget, std::min(budget, _maxBudget));
+
+    // Noise falls with the square root of samples, so the threshold the previous frame would
+    // have reached at the min budget makes this one take it instead of stopping early
+    if (_lastReachedThreshold && _lastSamples > 0 && _lastSamples < _minBudget) {
+        _noiseThreshold = noiseThreshold * std::sqrt(double(_lastSamples) / _minBudget);
+        SetNumericSetting(renderDelegate, _tokens->noiseThreshold, _noiseThreshold);
+    }
+
+    if (_budget != maxSamples) {
+        ProductionSettings::ApplyOverride(renderDelegate, _tokens->maxSamples, VtValue(_budget));
+    }
+
+    size_t hash = (size_t)ArchHash64((const char*)&_budget, sizeof(_budget), settingsHash);
+    return (size_t)ArchHash64((const char*)&_noiseThreshold, sizeof(_noiseThreshold), hash);
+}
+
+bool TemporalSampleBudget::Raise(HdRenderDelegate* renderDelegate)
+{
+    if (_budget <= 0 || _budget >= _maxBudget) {
+        return false;
+    }
+
+    _budget = std::min(_budget * 2, _maxBudget);
+    ProductionSettings::ApplyOverride(renderDelegate, _tokens->maxSamples, VtValue(_budget));
+    return true;
+}
+
+bool TemporalSampleBudget::ReachedThreshold(int64_t completedSamples) const
+{
+    // Without adaptive sampling or sample count there is no threshold to miss
+    return _noiseThreshold <= 0.0 || completedSamples < 0 || completedSamples < _budget;
+}
+
+void TemporalSampleBudget::Update(int64_t completedSamples)
+{
+    _lastSamples = completedSamples;
+    _lastReachedThreshold = ReachedThreshold(completedSamples);
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
@@ -0,0 +1,79 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef __RPRUSDTEMPORALSAMPLEBUDGET__
+#define __RPRUSDTEMPORALSAMPLEBUDGET__
+
+#pragma warning(push, 0)
+
+#include <pxr/pxr.h>
+
+#pragma warning(pop)
+
+#include <cstddef>
+#include <cstdint>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+class HdRenderDelegate;
+
+/**
+ * Picks the sample budget and the noise threshold of a sequence frame from how the previous frame
+ * converged. Neighbouring frames of a shot converge similarly, so the budget follows the samples
+ * the last frame needed to reach the adaptive sampling noise threshold, with some headroom, within
+ * the min and max budget. A frame which used up its budget before reaching the threshold is
+ * rendered again with a raised budget. Threshold stays as set by the artist unless the previous
+ * frame reached it before the min budget, then it's lowered so the min budget goes to less noise.
+ */
+class TemporalSampleBudget
+{
+public:
+    /** Forget the history, called when a sequence starts. */
+    void Reset();
+
+    /** Set the budget as max samples and the noise threshold of the delegate with the artist
+     * settings already applied. Min and max budget of 0 take adaptive min samples and max
+     * samples. Return the settings hash including the budget and the threshold. */
+    size_t Apply(
+        HdRenderDelegate* renderDelegate,
+        size_t            settingsHash,
+        int               minBudget,
+        int               maxBudget);
+
+    /** Double the budget of the frame which used it up before reaching the noise threshold.
+     * Return false if the budget is already at the max. */
+    bool Raise(HdRenderDelegate* renderDelegate);
+
+    /** Return true if the frame stopped at the noise threshold rather than at the budget. */
+    bool ReachedThreshold(int64_t completedSamples) const;
+
+    /** Record the samples the frame was rendered with, negative if unknown. */
+    void Update(int64_t completedSamples);
+
+    /** Max samples the current frame is rendered with. */
+    int    GetBudget() const { return _budget; }
+    double GetNoiseThreshold() const { return _noiseThreshold; }
+
+private:
+    size_t  _settingsHash = 0;
+    int     _budget = 0;
+    int     _minBudget = 0;
+    int     _maxBudget = 0;
+    double  _noiseThreshold = 0.0;
+    int64_t _lastSamples = -1;
+    bool    _lastReachedThreshold = false;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif //__RPRUSDTEMPORALSAMPLEBUDGET__
@@ -0,0 +1,237 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "UsdCameraIndex.h"
+
+#include <maya/MGlobal.h>
+#include <maya/MTimerMessage.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+// Scan runs for kScanBudget seconds every kScanTimerPeriod seconds
+static const float  kScanTimerPeriod = 0.05f;
+static const double kScanBudget = 0.01;
+
+// Reading the clock per prim would cost as much as the scan itself
+static const size_t kPrimsPerClockCheck = 256;
+
+UsdCameraIndex::~UsdCameraIndex() { Clear(); }
+
+void UsdCameraIndex::SetStage(const UsdStageRefPtr& stage)
+{
+    if (stage && stage == _stage) {
+        // Index is up to date, UI could be rebuilt by the settings window
+        if (!_isScanning && _pendingRoots.empty()) {
+            UpdateUi();
+        }
+        return;
+    }
+
+    Clear();
+    MGlobal::executeCommand("HdRpr_clearUSDCameras();");
+
+    if (!stage) {
+        return;
+    }
+
+    _stage = stage;
+    _objectsChangedKey = TfNotice::Register(
+        TfCreateWeakPtr(this), &UsdCameraIndex::OnObjectsChanged, _stage);
+
+    Schedule(SdfPath::AbsoluteRootPath());
+    StartScan();
+}
+
+void UsdCameraIndex::Clear()
+{
+    RemoveScanTimer();
+
+    if (_objectsChangedKey.IsValid()) {
+        TfNotice::Revoke(_objectsChangedKey);
+    }
+
+    _stage = UsdStageWeakPtr();
+    _cameras.clear();
+    _uiDirty = false;
+    _pendingRoots.clear();
+    _scanRange = UsdPrimRange();
+    _isScanning = false;
+}
+
+void UsdCameraIndex::OnObjectsChanged(
+    const UsdNotice::ObjectsChanged& notice,
+    const UsdStageWeakPtr&           sender)
+{
+    UsdNotice::ObjectsChanged::PathRange resyncedPaths = notice.GetResyncedPaths();
+    if (resyncedPaths.empty()) {
+        return;
+    }
+
+    // Iterator of the interrupted scan may point to the removed prims
+    if (_isScanning) {
+        _isScanning = false;
+        _scanRange = UsdPrimRange();
+        Schedule(_scanRoot);
+    }
+
+    for (const SdfPath& path : resyncedPaths) {
+        // Property resync doesn't change the prim type
+        if (path.IsPrimPath() || path.IsAbsoluteRootPath()) {
+            Schedule(path);
+        }
+    }
+
+    StartScan();
+}
+
+void UsdCameraIndex::Schedule(const SdfPath& root)
+{
+    // Descendants of the root follow it in the sorted set
+    auto it = _cameras.lower_bound(root);
+    while (it != _cameras.end() && it->HasPrefix(root)) {
+        it = _cameras.erase(it);
+        _uiDirty = true;
+    }
+
+    for (const SdfPath& pendingRoot : _pendingRoots) {
+        if (root.HasPrefix(pendingRoot)) {
+            return;
+        }
+    }
+
+    _pendingRoots.erase(
+        std::remove_if(
+            _pendingRoots.begin(),
+            _pendingRoots.end(),
+            [&root](const SdfPath& pendingRoot) { return pendingRoot.HasPrefix(root); }),
+        _pendingRoots.end());
+    _pendingRoots.push_back(root);
+}
+
+void UsdCameraIndex::StartScan()
+{
+    // There is no event loop to drive the timer in batch mode
+    if (MGlobal::mayaState() != MGlobal::kInteractive) {
+        Scan(std::numeric_limits<double>::infinity());
+        if (_uiDirty) {
+            UpdateUi();
+        }
+        return;
+    }
+
+    if (_scanTimerId) {
+        return;
+    }
+
+    MStatus status;
+    _scanTimerId = MTimerMessage::addTimerCallback(kScanTimerPeriod, OnScanTimer, this, &status);
+    CHECK_MSTATUS(status);
+}
+
+bool UsdCameraIndex::Scan(double budgetSeconds)
+{
+    UsdStageRefPtr stage = _stage;
+    if (!stage) {
+        _pendingRoots.clear();
+        _isScanning = false;
+        return true;
+    }
+
+    const auto deadline
+        = std::chrono::steady_clock::now() + std::chrono::duration<double>(budgetSeconds);
+    size_t visitedCount = 0;
+
+    while (true) {
+        if (!_isScanning) {
+            if (_pendingRoots.empty()) {
+                return true;
+            }
+
+            _scanRoot = _pendingRoots.back();
+            _pendingRoots.pop_back();
+
+            UsdPrim root = stage->GetPrimAtPath(_scanRoot);
+            if (!root) {
+                continue;
+            }
+
+            _scanRange = UsdPrimRange(root, UsdPrimAllPrimsPredicate);
+            _scanIt = _scanRange.begin();
+            _isScanning = true;
+        }
+
+        while (_scanIt != _scanRange.end()) {
+            if (_scanIt->GetTypeName() == "Camera") {
+                _cameras.insert(_scanIt->GetPath());
+                _uiDirty = true;
+            }
+            ++_scanIt;
+
+            if ((++visitedCount % kPrimsPerClockCheck) == 0
+                && std::chrono::steady_clock::now() > deadline) {
+                return false;
+            }
+        }
+
+        _isScanning = false;
+        _scanRange = UsdPrimRange();
+    }
+}
+
+void UsdCameraIndex::UpdateUi()
+{
+    _uiDirty = false;
+
+    // Whole list goes in one command instead of a command per camera
+    MString cmd = "{ string $cameras[]";
+    if (!_cameras.empty()) {
+        cmd += " = {";
+        for (auto it = _cameras.begin(); it != _cameras.end(); ++it) {
+            cmd += it == _cameras.begin() ? "\"" : ", \"";
+            cmd += it->GetText();
+            cmd += "\"";
+        }
+        cmd += "}";
+    }
+    cmd += "; HdRpr_setUSDCameras($cameras); }";
+
+    MGlobal::executeCommand(cmd);
+}
+
+void UsdCameraIndex::OnScanTimer(float, float, void* pClientData)
+{
+    UsdCameraIndex* index = static_cast<UsdCameraIndex*>(pClientData);
+
+    if (!index->Scan(kScanBudget)) {
+        return;
+    }
+
+    index->RemoveScanTimer();
+    if (index->_uiDirty) {
+        index->UpdateUi();
+    }
+}
+
+void UsdCameraIndex::RemoveScanTimer()
+{
+    if (_scanTimerId) {
+        MTimerMessage::removeCallback(_scanTimerId);
+        _scanTimerId = 0;
+    }
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
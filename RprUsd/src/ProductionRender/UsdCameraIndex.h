@@ -0,0 +1,86 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef __RPRUSDUSDCAMERAINDEX__
+#define __RPRUSDUSDCAMERAINDEX__
+
+#include <maya/MMessage.h>
+
+#pragma warning(push, 0)
+
+#include <pxr/base/tf/notice.h>
+#include <pxr/base/tf/weakBase.h>
+#include <pxr/pxr.h>
+#include <pxr/usd/sdf/path.h>
+#include <pxr/usd/usd/notice.h>
+#include <pxr/usd/usd/primRange.h>
+#include <pxr/usd/usd/stage.h>
+
+#pragma warning(pop)
+
+#include <set>
+#include <vector>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+/**
+ * Cameras of the usd stage listed in the production render settings.
+ * Only subtrees resynced by UsdNotice::ObjectsChanged are scanned again. In interactive session
+ * scanning is sliced between timer ticks, so a heavy stage doesn't block Maya, and the camera
+ * list UI is updated once the scan is finished.
+ */
+class UsdCameraIndex : public TfWeakBase
+{
+public:
+    UsdCameraIndex() = default;
+    ~UsdCameraIndex();
+
+    /** Track the stage. A new stage is scanned from scratch, the same one only updates the UI. */
+    void SetStage(const UsdStageRefPtr& stage);
+
+    /** Stop tracking the stage. */
+    void Clear();
+
+private:
+    void OnObjectsChanged(const UsdNotice::ObjectsChanged& notice, const UsdStageWeakPtr& sender);
+
+    /** Forget cameras under the root and scan it again. */
+    void Schedule(const SdfPath& root);
+    void StartScan();
+
+    /** Return true if all scheduled subtrees are scanned. */
+    bool Scan(double budgetSeconds);
+    void UpdateUi();
+
+    static void OnScanTimer(float, float, void* pClientData);
+    void        RemoveScanTimer();
+
+private:
+    UsdStageWeakPtr _stage;
+    TfNotice::Key   _objectsChangedKey;
+
+    std::set<SdfPath> _cameras;
+    bool              _uiDirty = false;
+
+    std::vector<SdfPath>   _pendingRoots;
+    SdfPath                _scanRoot;
+    UsdPrimRange           _scanRange;
+    UsdPrimRange::iterator _scanIt;
+    bool                   _isScanning = false;
+
+    MCallbackId _scanTimerId = 0;
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif //__RPRUSDUSDCAMERAINDEX__
@@ -15,29 +15,156 @@
 
 #include <mayaUsd/nodes/layerManager.h>
 
+#include <maya/MDGMessage.h>
 #include <maya/MItDependencyNodes.h>
+#include <maya/MObjectHandle.h>
 #include <maya/MSelectionList.h>
 
+#include <algorithm>
+#include <vector>
+
 std::string GetRendererName() { return "HdRprPlugin"; }
 
-MayaUsdProxyShapeBase* GetMayaUsdProxyShapeBase()
+namespace {
+
+// Live proxy shapes in creation order, kept by the node added and removed callbacks
+std::vector<MObjectHandle> g_proxyShapes;
+bool                       g_proxyShapeRegistryInitialized = false;
+MCallbackId                g_proxyShapeAddedCallback = 0;
+MCallbackId                g_proxyShapeRemovedCallback = 0;
+
+// Proxy shape of the rendered stage, resolved again after the registry or selection change
+MObjectHandle g_activeProxyShape;
+bool          g_activeProxyShapeValid = false;
+
+void OnProxyShapeAdded(MObject& node, void*)
+{
+    MFnDependencyNode depNode(node);
+    if (MayaUsd::LayerManager::supportedNodeType(depNode.typeId())) {
+        g_proxyShapes.emplace_back(node);
+        g_activeProxyShapeValid = false;
+    }
+}
+
+void OnProxyShapeRemoved(MObject& node, void*)
+{
+    MObjectHandle handle(node);
+    auto          it = std::find(g_proxyShapes.begin(), g_proxyShapes.end(), handle);
+    if (it != g_proxyShapes.end()) {
+        g_proxyShapes.erase(it);
+        g_activeProxyShapeValid = false;
+    }
+}
+
+void InitializeProxyShapeRegistry()
 {
+    if (g_proxyShapeRegistryInitialized) {
+        return;
+    }
+    g_proxyShapeRegistryInitialized = true;
+
+    // The only scan, shapes created later are reported by the callbacks
     MFnDependencyNode  fn;
     MItDependencyNodes iter(MFn::kPluginDependNode);
     for (; !iter.isDone(); iter.next()) {
         MObject mobj = iter.thisNode();
         fn.setObject(mobj);
+        if (MayaUsd::LayerManager::supportedNodeType(fn.typeId())) {
+            g_proxyShapes.emplace_back(mobj);
+        }
+    }
 
-        MString origRTypeName = MayaUsdProxyShapeBase::typeName;
-        if (!fn.isFromReferencedFile() && (MayaUsd::LayerManager::supportedNodeType(fn.typeId()))) {
-            MayaUsdProxyShapeBase* pShape = static_cast<MayaUsdProxyShapeBase*>(fn.userNode());
-            if (pShape) {
-                return pShape;
+    MStatus status;
+    g_proxyShapeAddedCallback = MDGMessage::addNodeAddedCallback(
+        OnProxyShapeAdded, "dependNode", nullptr, &status);
+    CHECK_MSTATUS(status);
+    g_proxyShapeRemovedCallback = MDGMessage::addNodeRemovedCallback(
+        OnProxyShapeRemoved, "dependNode", nullptr, &status);
+    CHECK_MSTATUS(status);
+}
+
+MObject ResolveActiveProxyShape()
+{
+    std::vector<MObject> candidates;
+    for (const MObjectHandle& handle : g_proxyShapes) {
+        if (!handle.isAlive()) {
+            continue;
+        }
+
+        MFnDependencyNode fn(handle.object());
+        if (!fn.isFromReferencedFile() && fn.userNode()) {
+            candidates.push_back(handle.object());
+        }
+    }
+
+    std::string selectedName;
+    MObject     settingsNode = GetSettingsNode();
+    if (!settingsNode.isNull()) {
+        MFnDependencyNode node(settingsNode);
+        _GetAttribute(node, "HdRprPlugin_Prod_Static_usdProxyShape", selectedName, false);
+    }
+
+    if (!selectedName.empty()) {
+        for (const MObject& candidate : candidates) {
+            if (selectedName == MFnDependencyNode(candidate).name().asChar()) {
+                return candidate;
             }
         }
+
+        MGlobal::displayWarning(
+            MString("[hdRPR] USD proxy shape was not found: ") + selectedName.c_str());
     }
 
-    return nullptr;
+    if (candidates.empty()) {
+        return MObject();
+    }
+
+    if (candidates.size() > 1) {
+        MGlobal::displayWarning(
+            MString("[hdRPR] Scene has several USD stages, rendering ")
+            + MFnDependencyNode(candidates.front()).name()
+            + ". Select another one with the USD Proxy Shape render setting.");
+    }
+
+    return candidates.front();
+}
+
+} // namespace
+
+MayaUsdProxyShapeBase* GetMayaUsdProxyShapeBase()
+{
+    InitializeProxyShapeRegistry();
+
+    if (!g_activeProxyShapeValid || !g_activeProxyShape.isAlive()) {
+        g_activeProxyShape = MObjectHandle(ResolveActiveProxyShape());
+        g_activeProxyShapeValid = true;
+    }
+
+    if (!g_activeProxyShape.isAlive()) {
+        return nullptr;
+    }
+
+    MFnDependencyNode fn(g_activeProxyShape.object());
+    return static_cast<MayaUsdProxyShapeBase*>(fn.userNode());
+}
+
+void InvalidateActiveProxyShape() { g_activeProxyShapeValid = false; }
+
+void ClearProxyShapeRegistry()
+{
+    if (g_proxyShapeAddedCallback) {
+        MMessage::removeCallback(g_proxyShapeAddedCallback);
+        g_proxyShapeAddedCallback = 0;
+    }
+    if (g_proxyShapeRemovedCallback) {
+        MMessage::removeCallback(g_proxyShapeRemovedCallback);
+        g_proxyShapeRemovedCallback = 0;
+    }
+
+    g_proxyShapes.clear();
+    g_proxyShapeRegistryInitialized = false;
+    g_activeProxyShape = MObjectHandle();
+    g_activeProxyShapeValid = false;
 }
 
 UsdStageRefPtr GetUsdStage()
@@ -34,8 +34,13 @@
 
 std::string GetRendererName();
 
+// Proxy shape selected by the usdProxyShape setting, the first one created if it's empty
 MayaUsdProxyShapeBase* GetMayaUsdProxyShapeBase();
 UsdStageRefPtr         GetUsdStage();
+// Resolve the proxy shape again on the next call, e.g. when the selection changes
+void InvalidateActiveProxyShape();
+// Forget proxy shapes and remove the callbacks which track them
+void ClearProxyShapeRegistry();
 
 MObject GetSettingsNode();
 
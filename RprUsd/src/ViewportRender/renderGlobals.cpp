@@ -17,6 +17,7 @@
 
 #include "pxr/usd/usdRender/settings.h"
 #include "renderOverride.h"
+#include "renderSettingsSnapshot.h"
 #include "utils.h"
 
 #include <pxr/imaging/hd/renderDelegate.h>
@@ -668,23 +669,23 @@ bool MtohRenderGlobals::ApplySettings(
         return false;
     }
 
-    bool appliedAny = false;
+    // Values the delegate already has are skipped, so they don't restart the render
+    bool changedAny = false;
     if (!attrNames.empty()) {
         for (auto& mangledAttr : attrNames) {
             if (const auto* setting = TfMapLookupPtr(*settings, mangledAttr)) {
-                delegate->SetRenderSetting(_DeMangleString(mangledAttr, rendererName), *setting);
-                appliedAny = true;
+                changedAny |= MtohRenderSettingsSnapshot::Apply(
+                    delegate, _DeMangleString(mangledAttr, rendererName), *setting);
             }
         }
     } else {
         for (auto&& setting : *settings) {
-            delegate->SetRenderSetting(
-                _DeMangleString(setting.first, rendererName), setting.second);
+            changedAny |= MtohRenderSettingsSnapshot::Apply(
+                delegate, _DeMangleString(setting.first, rendererName), setting.second);
         }
-        appliedAny = true;
     }
 
-    return appliedAny;
+    return changedAny;
 }
 
 void MtohRenderGlobals::OptionsPreamble()
@@ -79,7 +79,7 @@ public:
         const HdRenderSettingDescriptorList& rendererSettingDescriptors);
 
     // Apply the given setting (or all of a delegate's settings when attrNames is empty) to the
-    // given renderDelegate
+    // given renderDelegate, return true if any value differs from the one the delegate had
     bool ApplySettings(
         HdRenderDelegate*    delegate,
         const TfToken&       rendererName,
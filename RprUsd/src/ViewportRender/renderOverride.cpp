@@ -17,6 +17,7 @@
 
 #include "pluginDebugCodes.h"
 #include "renderOverrideUtils.h"
+#include "renderSettingsSnapshot.h"
 #include "tokens.h"
 #include "utils.h"
 
@@ -281,6 +282,7 @@ MtohRenderOverride::~MtohRenderOverride()
     if (_timerCallback)
         MMessage::removeCallback(_timerCallback);
 
+    // Production render borrowing the index is stopped by ClearHydraResources
     ClearHydraResources();
 
     for (auto operation : _operations) {
@@ -313,7 +315,10 @@ void MtohRenderOverride::UpdateRenderGlobals(
     // If no attribute or attribute starts with 'mtoh', these setting wil be applied on the next
     // call to MtohRenderOverride::Render, so just force an invalidation
     // XXX: This will need to change if mtoh settings should ever make it to the delegate itself.
+    bool changed = true;
     if (attrName.GetString().find("mtoh") != 0) {
+        // Re-applying the same values, e.g. from a re-opened option box, keeps the convergence
+        changed = false;
         std::lock_guard<std::mutex> lock(_allInstancesMutex);
         for (auto* instance : _allInstances) {
             const auto& rendererName = instance->_rendererDesc.rendererName;
@@ -326,7 +331,7 @@ void MtohRenderOverride::UpdateRenderGlobals(
 
             // Will be applied in _InitHydraResources later anyway
             if (auto* renderDelegate = instance->_GetRenderDelegate()) {
-                instance->_globals.ApplySettings(
+                changed |= instance->_globals.ApplySettings(
                     renderDelegate,
                     instance->_rendererDesc.rendererName,
                     TfTokenVector(attrFilter, attrName));
@@ -338,7 +343,9 @@ void MtohRenderOverride::UpdateRenderGlobals(
     }
 
     // Less than ideal still
-    MGlobal::executeCommandOnIdle("refresh -f");
+    if (changed) {
+        MGlobal::executeCommandOnIdle("refresh -f");
+    }
 }
 
 std::vector<MString> MtohRenderOverride::AllActiveRendererNames()
@@ -397,6 +404,44 @@ SdfPath MtohRenderOverride::RendererSceneDelegateId(TfToken rendererName, TfToke
     return SdfPath();
 }
 
+HdRenderIndex* MtohRenderOverride::AcquireRenderIndex(
+    TfToken               rendererName,
+    std::function<void()> revokeCallback)
+{
+    MtohRenderOverride* instance = _GetByName(rendererName);
+    if (!instance || !instance->_initializationSucceeded || !instance->_renderIndex) {
+        return nullptr;
+    }
+
+    // Scene lights are not populated while Maya default light is used
+    if (instance->_hasDefaultLighting || instance->_renderIndexLent) {
+        return nullptr;
+    }
+
+    instance->_renderIndexLent = true;
+    instance->_renderIndexRevokeCallback = std::move(revokeCallback);
+    return instance->_renderIndex;
+}
+
+void MtohRenderOverride::ReleaseRenderIndex(TfToken rendererName)
+{
+    MtohRenderOverride* instance = _GetByName(rendererName);
+    if (!instance || !instance->_renderIndexLent) {
+        return;
+    }
+
+    instance->_renderIndexLent = false;
+    instance->_renderIndexRevokeCallback = nullptr;
+
+    // Production render applied its own settings and stopped the delegate
+    if (auto* renderDelegate = instance->_GetRenderDelegate()) {
+        instance->_globals.ApplySettings(renderDelegate, instance->_rendererDesc.rendererName);
+        renderDelegate->Restart();
+    }
+
+    MGlobal::executeCommandOnIdle("refresh -f");
+}
+
 void MtohRenderOverride::_DetectMayaDefaultLighting(const MHWRender::MDrawContext& drawContext)
 {
     constexpr auto considerAllSceneLights = MHWRender::MDrawContext::kFilteredIgnoreLightLimit;
@@ -535,6 +580,11 @@ MStatus MtohRenderOverride::Render(const MHWRender::MDrawContext& drawContext)
         return MStatus::kFailure;
     }
 
+    if (_renderIndexLent) {
+        // Production render is using the render index
+        return MStatus::kSuccess;
+    }
+
     _DetectMayaDefaultLighting(drawContext);
     if (_needsClear.exchange(false)) {
         ClearHydraResources();
@@ -820,6 +870,21 @@ void MtohRenderOverride::_InitHydraResources()
 
 void MtohRenderOverride::ClearHydraResources()
 {
+    if (_renderIndexLent) {
+        // Production render is using the render index, it's stopped and returns the index
+        // before the index is deleted
+        std::function<void()> revokeCallback = std::move(_renderIndexRevokeCallback);
+        _renderIndexRevokeCallback = nullptr;
+        if (revokeCallback) {
+            revokeCallback();
+        }
+
+        if (_renderIndexLent) {
+            TF_CODING_ERROR("Render index is still used by the production render");
+            _renderIndexLent = false;
+        }
+    }
+
     if (!_initializationAttempted) {
         return;
     }
@@ -853,6 +918,7 @@ void MtohRenderOverride::ClearHydraResources()
 
     if (_rendererPlugin != nullptr) {
         if (renderDelegate != nullptr) {
+            MtohRenderSettingsSnapshot::Forget(renderDelegate);
             _rendererPlugin->DeleteRenderDelegate(renderDelegate);
         }
         HdRendererPluginRegistry::GetInstance().ReleasePlugin(_rendererPlugin);
@@ -1138,7 +1204,7 @@ void MtohRenderOverride::_PlayblastingChanged(bool playBlasting, void* userData)
 void MtohRenderOverride::_TimerCallback(float, float, void* data)
 {
     auto* instance = reinterpret_cast<MtohRenderOverride*>(data);
-    if (instance->_playBlasting || instance->_isConverged) {
+    if (instance->_playBlasting || instance->_isConverged || instance->_renderIndexLent) {
         return;
     }
 
@@ -37,6 +37,7 @@
 
 #include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <mutex>
 
@@ -80,6 +81,20 @@ public:
     /// Intended mostly for use in debugging and testing.
     static SdfPath RendererSceneDelegateId(TfToken rendererName, TfToken sceneDelegateName);
 
+    /// Lends the render index synced by the viewport to the production render, so the scene
+    /// doesn't have to be synced again. Viewport rendering is paused until the index is
+    /// returned with ReleaseRenderIndex.
+    ///
+    /// Returns nullptr when the viewport of the given renderer is not running or its scene
+    /// can't be used for final rendering (Maya default lighting).
+    ///
+    /// revokeCallback is called when the viewport has to delete the index while it's lent
+    /// (viewport destruction, scene change). The borrower must stop using the index and return
+    /// it with ReleaseRenderIndex before the callback returns.
+    static HdRenderIndex*
+    AcquireRenderIndex(TfToken rendererName, std::function<void()> revokeCallback);
+    static void ReleaseRenderIndex(TfToken rendererName);
+
     MStatus Render(const MHWRender::MDrawContext& drawContext);
 
     void ClearHydraResources();
@@ -159,6 +174,8 @@ private:
     std::atomic<bool>                     _playBlasting = { false };
     std::atomic<bool>                     _isConverged = { false };
     std::atomic<bool>                     _needsClear = { false };
+    std::atomic<bool>                     _renderIndexLent = { false };
+    std::function<void()>                 _renderIndexRevokeCallback;
 
     /// Hgi and HdDriver should be constructed before HdEngine to ensure they
     /// are destructed last. Hgi may be used during engine/delegate destruction.
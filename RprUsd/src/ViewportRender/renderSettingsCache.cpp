@@ -0,0 +1,334 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "renderSettingsCache.h"
+
+#pragma warning(push, 0)
+
+#include <pxr/base/arch/fileSystem.h>
+#include <pxr/base/gf/vec3f.h>
+#include <pxr/base/gf/vec4f.h>
+#include <pxr/base/js/json.h>
+#include <pxr/base/plug/plugin.h>
+#include <pxr/base/plug/registry.h>
+#include <pxr/base/tf/atomicOfstreamWrapper.h>
+#include <pxr/base/tf/enum.h>
+#include <pxr/base/tf/fileUtils.h>
+#include <pxr/base/tf/stringUtils.h>
+#include <pxr/base/tf/type.h>
+#include <pxr/imaging/hd/rendererPlugin.h>
+#include <pxr/usd/sdf/assetPath.h>
+
+#pragma warning(pop)
+
+#include <maya/MGlobal.h>
+
+#include <fstream>
+#include <unordered_map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+// Bump when the file layout changes
+constexpr int kCacheVersion = 1;
+
+// Identifies the build of the renderer plugin, empty if it can't be found
+std::string GetPluginBuildKey(const TfToken& rendererName)
+{
+    TfType        type = TfType::FindByName(rendererName.GetString());
+    PlugPluginPtr plugin = PlugRegistry::GetInstance().GetPluginForType(type);
+    if (!plugin) {
+        return {};
+    }
+
+    const std::string& path = plugin->GetPath();
+
+    double modificationTime = 0.0;
+    if (!ArchGetModificationTime(path.c_str(), &modificationTime)) {
+        return {};
+    }
+
+    return TfStringPrintf(
+        "%s;%lld;%.6f;%d",
+        path.c_str(),
+        (long long)ArchGetFileLength(path.c_str()),
+        modificationTime,
+        PXR_VERSION);
+}
+
+std::string GetCacheFilePath(const TfToken& rendererName)
+{
+    MString userAppDir = MGlobal::executeCommandStringResult("internalVar -userAppDir");
+    if (userAppDir.length() == 0) {
+        return {};
+    }
+
+    return TfStringCatPaths(
+        TfStringCatPaths(userAppDir.asChar(), "rprUsd"),
+        rendererName.GetString() + "_settings.json");
+}
+
+JsArray ToJsArray(const float* values, size_t count)
+{
+    JsArray array;
+    for (size_t i = 0; i < count; ++i) {
+        array.emplace_back(double(values[i]));
+    }
+    return array;
+}
+
+bool FromJsArray(const JsValue& value, float* values, size_t count)
+{
+    if (!value.IsArray() || value.GetJsArray().size() != count) {
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        const JsValue& item = value.GetJsArray()[i];
+        if (item.IsInt()) {
+            values[i] = float(item.GetInt64());
+        } else if (item.IsReal()) {
+            values[i] = float(item.GetReal());
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool ToJsValue(const VtValue& value, JsObject& object)
+{
+    if (value.IsHolding<bool>()) {
+        object["type"] = JsValue("bool");
+        object["value"] = JsValue(value.UncheckedGet<bool>());
+    } else if (value.IsHolding<int>()) {
+        object["type"] = JsValue("int");
+        object["value"] = JsValue(value.UncheckedGet<int>());
+    } else if (value.IsHolding<float>()) {
+        object["type"] = JsValue("float");
+        object["value"] = JsValue(double(value.UncheckedGet<float>()));
+    } else if (value.IsHolding<GfVec3f>()) {
+        object["type"] = JsValue("vec3f");
+        object["value"] = JsValue(ToJsArray(value.UncheckedGet<GfVec3f>().data(), 3));
+    } else if (value.IsHolding<GfVec4f>()) {
+        object["type"] = JsValue("vec4f");
+        object["value"] = JsValue(ToJsArray(value.UncheckedGet<GfVec4f>().data(), 4));
+    } else if (value.IsHolding<TfToken>()) {
+        object["type"] = JsValue("token");
+        object["value"] = JsValue(value.UncheckedGet<TfToken>().GetString());
+    } else if (value.IsHolding<std::string>()) {
+        object["type"] = JsValue("string");
+        object["value"] = JsValue(value.UncheckedGet<std::string>());
+    } else if (value.IsHolding<SdfAssetPath>()) {
+        object["type"] = JsValue("asset");
+        object["value"] = JsValue(value.UncheckedGet<SdfAssetPath>().GetAssetPath());
+    } else if (value.IsHolding<TfEnum>()) {
+        object["type"] = JsValue("enum");
+        object["value"] = JsValue(TfEnum::GetFullName(value.UncheckedGet<TfEnum>()));
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool FromJsValue(const JsObject& object, VtValue& value)
+{
+    auto typeIt = object.find("type");
+    auto valueIt = object.find("value");
+    if (typeIt == object.end() || valueIt == object.end() || !typeIt->second.IsString()) {
+        return false;
+    }
+
+    const std::string& type = typeIt->second.GetString();
+    const JsValue&     jsValue = valueIt->second;
+
+    if (type == "bool" && jsValue.IsBool()) {
+        value = jsValue.GetBool();
+    } else if (type == "int" && jsValue.IsInt()) {
+        value = jsValue.GetInt();
+    } else if (type == "float" && (jsValue.IsReal() || jsValue.IsInt())) {
+        value = jsValue.IsInt() ? float(jsValue.GetInt64()) : float(jsValue.GetReal());
+    } else if (type == "vec3f") {
+        GfVec3f v;
+        if (!FromJsArray(jsValue, v.data(), 3)) {
+            return false;
+        }
+        value = v;
+    } else if (type == "vec4f") {
+        GfVec4f v;
+        if (!FromJsArray(jsValue, v.data(), 4)) {
+            return false;
+        }
+        value = v;
+    } else if (type == "token" && jsValue.IsString()) {
+        value = TfToken(jsValue.GetString());
+    } else if (type == "string" && jsValue.IsString()) {
+        value = jsValue.GetString();
+    } else if (type == "asset" && jsValue.IsString()) {
+        value = SdfAssetPath(jsValue.GetString());
+    } else if (type == "enum" && jsValue.IsString()) {
+        // Enum type has to be registered by the renderer plugin loaded already
+        bool   found = false;
+        TfEnum e = TfEnum::GetValueFromFullName(jsValue.GetString(), &found);
+        if (!found) {
+            return false;
+        }
+        value = e;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool ReadCache(
+    const std::string&             path,
+    const std::string&             buildKey,
+    HdRenderSettingDescriptorList& descriptors)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    JsValue root = JsParseStream(file);
+    if (!root.IsObject()) {
+        return false;
+    }
+
+    const JsObject& rootObject = root.GetJsObject();
+    auto            versionIt = rootObject.find("version");
+    auto            buildIt = rootObject.find("build");
+    auto            descriptorsIt = rootObject.find("descriptors");
+    if (versionIt == rootObject.end() || !versionIt->second.IsInt()
+        || versionIt->second.GetInt() != kCacheVersion || buildIt == rootObject.end()
+        || !buildIt->second.IsString() || buildIt->second.GetString() != buildKey
+        || descriptorsIt == rootObject.end() || !descriptorsIt->second.IsArray()) {
+        return false;
+    }
+
+    HdRenderSettingDescriptorList result;
+    for (const JsValue& item : descriptorsIt->second.GetJsArray()) {
+        if (!item.IsObject()) {
+            return false;
+        }
+
+        const JsObject& object = item.GetJsObject();
+        auto            nameIt = object.find("name");
+        auto            keyIt = object.find("key");
+        if (nameIt == object.end() || !nameIt->second.IsString() || keyIt == object.end()
+            || !keyIt->second.IsString()) {
+            return false;
+        }
+
+        HdRenderSettingDescriptor descriptor;
+        descriptor.name = nameIt->second.GetString();
+        descriptor.key = TfToken(keyIt->second.GetString());
+        if (!FromJsValue(object, descriptor.defaultValue)) {
+            return false;
+        }
+        result.push_back(std::move(descriptor));
+    }
+
+    descriptors = std::move(result);
+    return true;
+}
+
+void WriteCache(
+    const std::string&                   path,
+    const std::string&                   buildKey,
+    const HdRenderSettingDescriptorList& descriptors)
+{
+    JsArray jsDescriptors;
+    for (const HdRenderSettingDescriptor& descriptor : descriptors) {
+        JsObject object;
+        object["name"] = JsValue(descriptor.name);
+        object["key"] = JsValue(descriptor.key.GetString());
+
+        // Partial list would hide the setting next time, so nothing is cached at all
+        if (!ToJsValue(descriptor.defaultValue, object)) {
+            return;
+        }
+        jsDescriptors.emplace_back(object);
+    }
+
+    JsObject root;
+    root["version"] = JsValue(kCacheVersion);
+    root["build"] = JsValue(buildKey);
+    root["descriptors"] = JsValue(jsDescriptors);
+
+    if (!TfMakeDirs(TfGetPathName(path), -1, true)) {
+        return;
+    }
+
+    // Another Maya session may read the cache while it's written
+    TfAtomicOfstreamWrapper wrapper(path);
+    std::string             error;
+    if (!wrapper.Open(&error)) {
+        TF_WARN("[mtoh] Can't write render settings cache %s: %s", path.c_str(), error.c_str());
+        return;
+    }
+
+    JsWriteToStream(JsValue(root), wrapper.GetStream());
+
+    if (!wrapper.Commit(&error)) {
+        TF_WARN("[mtoh] Can't write render settings cache %s: %s", path.c_str(), error.c_str());
+    }
+}
+
+} // namespace
+
+bool MtohGetCachedRenderSettingDescriptors(
+    HdRendererPlugin*              plugin,
+    const TfToken&                 rendererName,
+    HdRenderSettingDescriptorList& descriptors)
+{
+    // Viewport and production render both ask for the descriptors during the plugin load
+    static std::unordered_map<TfToken, HdRenderSettingDescriptorList, TfToken::HashFunctor>
+        loaded;
+
+    auto loadedIt = loaded.find(rendererName);
+    if (loadedIt != loaded.end()) {
+        descriptors = loadedIt->second;
+        return true;
+    }
+
+    if (!plugin) {
+        return false;
+    }
+
+    const std::string buildKey = GetPluginBuildKey(rendererName);
+    const std::string path = GetCacheFilePath(rendererName);
+    const bool        canCache = !buildKey.empty() && !path.empty();
+
+    if (!canCache || !ReadCache(path, buildKey, descriptors)) {
+        HdRenderDelegate* delegate = plugin->CreateRenderDelegate();
+        if (!delegate) {
+            return false;
+        }
+
+        descriptors = delegate->GetRenderSettingDescriptors();
+
+        // We only needed the delegate for the settings, so release
+        plugin->DeleteRenderDelegate(delegate);
+
+        if (canCache) {
+            WriteCache(path, buildKey, descriptors);
+        }
+    }
+
+    loaded[rendererName] = descriptors;
+    return true;
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
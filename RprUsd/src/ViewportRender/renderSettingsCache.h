@@ -0,0 +1,39 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef MTOH_RENDER_SETTINGS_CACHE_H
+#define MTOH_RENDER_SETTINGS_CACHE_H
+
+#pragma warning(push, 0)
+
+#include <pxr/base/tf/token.h>
+#include <pxr/imaging/hd/renderDelegate.h>
+#include <pxr/pxr.h>
+
+#pragma warning(pop)
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+class HdRendererPlugin;
+
+// Return render setting descriptors of the renderer without creating its render delegate.
+// Descriptors are stored on disk keyed by the build of the renderer plugin, the delegate is
+// created only if the cache is missing or was written by another build.
+bool MtohGetCachedRenderSettingDescriptors(
+    HdRendererPlugin*              plugin,
+    const TfToken&                 rendererName,
+    HdRenderSettingDescriptorList& descriptors);
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // MTOH_RENDER_SETTINGS_CACHE_H
@@ -0,0 +1,88 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#include "renderSettingsSnapshot.h"
+
+#pragma warning(push, 0)
+
+#include <pxr/imaging/hd/renderDelegate.h>
+
+#pragma warning(pop)
+
+#include <mutex>
+#include <unordered_map>
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+namespace {
+
+struct Snapshot
+{
+    std::unordered_map<TfToken, VtValue, TfToken::HashFunctor> values;
+    // XOR of the entry hashes, updated in place when a value changes
+    size_t hash = 0;
+};
+
+std::mutex                                      g_snapshotsMutex;
+std::unordered_map<HdRenderDelegate*, Snapshot> g_snapshots;
+
+size_t EntryHash(const TfToken& key, const VtValue& value)
+{
+    size_t seed = key.Hash();
+    seed ^= value.GetHash() + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+    return seed;
+}
+
+} // namespace
+
+bool MtohRenderSettingsSnapshot::Apply(
+    HdRenderDelegate* delegate,
+    const TfToken&    key,
+    const VtValue&    value)
+{
+    {
+        std::lock_guard<std::mutex> lock(g_snapshotsMutex);
+
+        Snapshot& snapshot = g_snapshots[delegate];
+        auto      it = snapshot.values.find(key);
+        if (it != snapshot.values.end()) {
+            if (it->second == value) {
+                return false;
+            }
+            snapshot.hash ^= EntryHash(key, it->second);
+            it->second = value;
+        } else {
+            snapshot.values.emplace(key, value);
+        }
+        snapshot.hash ^= EntryHash(key, value);
+    }
+
+    delegate->SetRenderSetting(key, value);
+    return true;
+}
+
+size_t MtohRenderSettingsSnapshot::GetHash(HdRenderDelegate* delegate)
+{
+    std::lock_guard<std::mutex> lock(g_snapshotsMutex);
+
+    auto it = g_snapshots.find(delegate);
+    return it != g_snapshots.end() ? it->second.hash : 0;
+}
+
+void MtohRenderSettingsSnapshot::Forget(HdRenderDelegate* delegate)
+{
+    std::lock_guard<std::mutex> lock(g_snapshotsMutex);
+    g_snapshots.erase(delegate);
+}
+
+PXR_NAMESPACE_CLOSE_SCOPE
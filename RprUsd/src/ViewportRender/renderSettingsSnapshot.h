@@ -0,0 +1,47 @@
+//
+// Copyright 2023 Advanced Micro Devices, Inc
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//    http://www.apache.org/licenses/LICENSE-2.0
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+
+#ifndef MTOH_RENDER_SETTINGS_SNAPSHOT_H
+#define MTOH_RENDER_SETTINGS_SNAPSHOT_H
+
+#pragma warning(push, 0)
+
+#include <pxr/base/tf/token.h>
+#include <pxr/base/vt/value.h>
+#include <pxr/pxr.h>
+
+#pragma warning(pop)
+
+PXR_NAMESPACE_OPEN_SCOPE
+
+class HdRenderDelegate;
+
+// Settings applied to each render delegate with the hash of their content.
+// Viewport and production render share delegates, so both push settings through here: a value
+// the delegate already holds is not set again and doesn't restart the renderer.
+class MtohRenderSettingsSnapshot
+{
+public:
+    // Set the value unless the delegate already has it, return true if it was set
+    static bool Apply(HdRenderDelegate* delegate, const TfToken& key, const VtValue& value);
+
+    // Hash of all values applied to the delegate, doesn't depend on the order they were applied
+    static size_t GetHash(HdRenderDelegate* delegate);
+
+    // Drop the snapshot of the delegate, must be called before the delegate is deleted
+    static void Forget(HdRenderDelegate* delegate);
+};
+
+PXR_NAMESPACE_CLOSE_SCOPE
+
+#endif // MTOH_RENDER_SETTINGS_SNAPSHOT_H
@@ -28,6 +28,7 @@
 #include "utils.h"
 
 #include "renderGlobals.h"
+#include "renderSettingsCache.h"
 #include "tokens.h"
 
 #include <pxr/imaging/glf/contextCaps.h>
@@ -76,22 +77,15 @@ MtohInitializeRenderPlugins()
                 GlfContextCaps::InitInstance();
             }
 
-            HdRenderDelegate* delegate
-                = plugin->IsSupported() ? plugin->CreateRenderDelegate() : nullptr;
-
-            // No 'delete plugin', should plugin be cached as well?
-            if (!delegate) {
+            // Render delegate is created only when the cache of its settings is outdated
+            HdRenderSettingDescriptorList descriptors;
+            if (!plugin->IsSupported()
+                || !MtohGetCachedRenderSettingDescriptors(plugin, renderer, descriptors)) {
                 continue;
             }
 
             auto& rendererSettingDescriptors
-                = store.second.emplace(renderer, delegate->GetRenderSettingDescriptors())
-                      .first->second;
-
-            // We only needed the delegate for the settings, so release
-            plugin->DeleteRenderDelegate(delegate);
-            // Null it out to make any possible usage later obv, wrong!
-            delegate = nullptr;
+                = store.second.emplace(renderer, std::move(descriptors)).first->second;
 
             std::shared_ptr<UsdImagingGLEngine> _engine;
             store.first.emplace_back(
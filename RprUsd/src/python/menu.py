@@ -56,6 +56,23 @@ def BindMaterialXFromFile(value) :
         selected_path = selected_path[selected_path.find("/"):len(selected_path)]
         maya.cmds.rprUsdBindMtlx(pp=selected_path, mp=filePath)
 
+def DistributedRenderSequence(value) :
+    import rprUsdDistributedRender
+
+    ret = maya.cmds.promptDialog(title="Distributed Render Sequence", message="Number of worker processes:",
+        text=str(rprUsdDistributedRender.defaultWorkerCount()), button=["Render", "Cancel"], defaultButton="Render", cancelButton="Cancel")
+
+    if ret != "Render" :
+        return
+
+    try:
+        workers = int(maya.cmds.promptDialog(query=True, text=True))
+    except ValueError:
+        maya.OpenMaya.MGlobal.displayError("RprUsd: number of workers should be an integer!")
+        return
+
+    rprUsdDistributedRender.submit(workers=max(1, workers))
+
 def createRprUsdMenu():
     if not maya.cmds.menu("rprUsdMenuCtrl", exists=1):
         gMainWindow = "MayaWindow"
@@ -65,6 +82,7 @@ def createRprUsdMenu():
         maya.cmds.menuItem("loadUsdForSharing",label="Load Usd Stage For Sharing", p=rprUsdMenuCtrl, c=LoadUsdStageForSharing)
         maya.cmds.menuItem("runRenderStudio",label="Run RenderStudio", p=rprUsdMenuCtrl, c=RunRenderStudio)
         maya.cmds.menuItem("lightBrowserCtrl",label="Light Browser", p=rprUsdMenuCtrl, c=ShowLightBrowser)
+        maya.cmds.menuItem("distributedRenderCtrl",label="Distributed Render Sequence", p=rprUsdMenuCtrl, c=DistributedRenderSequence)
 
 def LoadUsdStageForSharing(value):  
     mel.eval("RprUsd_CreateStageFromFile();")
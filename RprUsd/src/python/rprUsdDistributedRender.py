@@ -0,0 +1,328 @@
+#
+# Copyright 2023 Advanced Micro Devices, Inc
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#    http://www.apache.org/licenses/LICENSE-2.0
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Local distribution of sequence rendering between several Maya batch processes.
+#
+# submit() runs inside Maya. It writes a job manifest and starts the scheduler (this module run
+# by mayapy) as a detached process. The scheduler splits the frames into chunks and keeps up to
+# N worker processes busy. A worker is a Maya batch session that renders its chunk headless and
+# reports every frame to the results folder. Frames that were not reported as done are re-queued
+# until maxAttempts is reached. Overall state goes to status.json in the job folder.
+
+import json
+import os
+import subprocess
+import sys
+import time
+
+MANIFEST_FILE_NAME = "manifest.json"
+STATUS_FILE_NAME = "status.json"
+RESULTS_FOLDER_NAME = "results"
+LOGS_FOLDER_NAME = "logs"
+
+STATE_PENDING = "pending"
+STATE_RUNNING = "running"
+STATE_DONE = "done"
+STATE_FAILED = "failed"
+
+POLL_INTERVAL = 1.0
+
+
+def _writeJson(path, data):
+    # Readers never see a partially written file
+    tmpPath = path + ".tmp"
+    with open(tmpPath, "w") as f:
+        json.dump(data, f, indent=2)
+    os.replace(tmpPath, path)
+
+
+def _readJson(path):
+    with open(path, "r") as f:
+        return json.load(f)
+
+
+def _frameKey(frame):
+    return "%g" % frame
+
+
+def _resultPath(jobFolder, frame):
+    return os.path.join(jobFolder, RESULTS_FOLDER_NAME, "frame_%s.json" % _frameKey(frame))
+
+
+# Maya side
+
+def defaultWorkerCount():
+    # A worker needs a few cores to keep the renderer and Maya evaluation busy
+    return max(1, min(4, (os.cpu_count() or 1) // 8))
+
+
+def submit(workers=None, threadsPerWorker=None, framesPerChunk=1, maxAttempts=3):
+    import maya.cmds
+
+    sceneFile = maya.cmds.file(query=True, sceneName=True)
+    if not sceneFile:
+        maya.cmds.error("RprUsd: save the scene before distributed rendering")
+        return None
+
+    if maya.cmds.file(query=True, modified=True):
+        maya.cmds.warning("RprUsd: the scene has unsaved changes, workers render the saved file")
+
+    if not workers:
+        workers = defaultWorkerCount()
+    if not threadsPerWorker:
+        threadsPerWorker = max(1, (os.cpu_count() or 1) // workers)
+
+    if maya.cmds.getAttr("defaultRenderGlobals.animation"):
+        startFrame = maya.cmds.getAttr("defaultRenderGlobals.startFrame")
+        endFrame = maya.cmds.getAttr("defaultRenderGlobals.endFrame")
+        byFrame = maya.cmds.getAttr("defaultRenderGlobals.byFrameStep")
+    else:
+        startFrame = endFrame = maya.cmds.currentTime(query=True)
+        byFrame = 1.0
+
+    frames = []
+    frame = startFrame
+    while frame <= endFrame:
+        frames.append(frame)
+        frame += byFrame
+
+    cameras = [c for c in maya.cmds.ls(type="camera") if maya.cmds.getAttr(c + ".renderable")]
+    if not cameras:
+        maya.cmds.error("RprUsd: no renderable cameras found")
+        return None
+
+    workspaceRoot = maya.cmds.workspace(query=True, rootDirectory=True)
+    sceneName = os.path.splitext(os.path.basename(sceneFile))[0]
+    jobFolder = os.path.join(
+        workspaceRoot, "renderData", "rprUsdJobs", sceneName + time.strftime("_%Y%m%d_%H%M%S"))
+    os.makedirs(os.path.join(jobFolder, RESULTS_FOLDER_NAME))
+    os.makedirs(os.path.join(jobFolder, LOGS_FOLDER_NAME))
+
+    mayaBin = os.path.join(os.environ["MAYA_LOCATION"], "bin")
+
+    manifest = {
+        "sceneFile": sceneFile,
+        "project": workspaceRoot,
+        "frames": frames,
+        "cameras": cameras,
+        "width": maya.cmds.getAttr("defaultResolution.width"),
+        "height": maya.cmds.getAttr("defaultResolution.height"),
+        "workers": workers,
+        "threadsPerWorker": threadsPerWorker,
+        "framesPerChunk": max(1, framesPerChunk),
+        "maxAttempts": max(1, maxAttempts),
+        "mayaBatch": os.path.join(mayaBin, "mayabatch.exe" if os.name == "nt" else "maya"),
+        "scriptsPath": os.path.dirname(os.path.abspath(__file__)),
+    }
+
+    manifestPath = os.path.join(jobFolder, MANIFEST_FILE_NAME)
+    _writeJson(manifestPath, manifest)
+
+    mayaPy = os.path.join(mayaBin, "mayapy.exe" if os.name == "nt" else "mayapy")
+    creationFlags = 0
+    if os.name == "nt":
+        creationFlags = subprocess.DETACHED_PROCESS | subprocess.CREATE_NEW_PROCESS_GROUP
+
+    subprocess.Popen(
+        [mayaPy, os.path.abspath(__file__), manifestPath],
+        creationflags=creationFlags,
+        close_fds=True)
+
+    print("RprUsd: distributed render of %d frames on %d workers, status: %s"
+          % (len(frames), workers, os.path.join(jobFolder, STATUS_FILE_NAME)))
+
+    return jobFolder
+
+
+def renderChunk(manifestPath, frames):
+    """ Worker entry point, runs in a Maya batch session with the scene loaded. """
+    import maya.cmds
+    import maya.mel
+
+    manifest = _readJson(manifestPath)
+    jobFolder = os.path.dirname(manifestPath)
+
+    if not maya.cmds.pluginInfo("RprUsd", query=True, loaded=True):
+        maya.cmds.loadPlugin("RprUsd")
+
+    # Renderer takes its CPU threads from the settings, workers don't compete for the same cores
+    maya.cmds.setAttr("defaultRenderGlobals.HdRprPlugin_Prod_Static_cpuThreadLimit",
+                      manifest["threadsPerWorker"])
+
+    # Re-queued chunk doesn't render again the frames its previous worker already wrote
+    extraOptions = ""
+    if maya.cmds.getAttr("defaultRenderGlobals.HdRprPlugin_Prod_Static_skipExistingFrames"):
+        extraOptions = " -skipExisting"
+
+    # Scene stays synced between frames of the chunk
+    maya.cmds.rprUsdRender(sequenceBegin=True)
+
+    try:
+        for frame in frames:
+            startTime = time.time()
+            maya.cmds.currentTime(frame)
+
+            try:
+                # All cameras of the frame are rendered against the same synced scene
+                cameraOptions = "".join(" -cam \"%s\"" % camera for camera in manifest["cameras"])
+                maya.mel.eval("rprUsdRender -w %d -h %d%s -headless -waitForIt -sequenceFrame%s"
+                              % (manifest["width"], manifest["height"], cameraOptions, extraOptions))
+
+                # Images are written in the background, the frame is done once they are on disk
+                imagePaths = maya.cmds.rprUsdRender(flushImages=True) or []
+                if len(imagePaths) < len(manifest["cameras"]):
+                    raise RuntimeError("%d of %d camera images were written"
+                                       % (len(imagePaths), len(manifest["cameras"])))
+                for imagePath in imagePaths:
+                    if not os.path.isfile(imagePath):
+                        raise RuntimeError("image is missing: " + imagePath)
+
+                state = STATE_DONE
+                error = ""
+            except RuntimeError as e:
+                state = STATE_FAILED
+                error = str(e)
+
+            _writeJson(_resultPath(jobFolder, frame), {
+                "frame": frame,
+                "state": state,
+                "error": error,
+                "renderTime": time.time() - startTime,
+            })
+    finally:
+        maya.cmds.rprUsdRender(sequenceEnd=True)
+
+
+# Scheduler side, runs by mayapy without Maya initialized
+
+class Scheduler(object):
+    def __init__(self, manifestPath):
+        self.manifestPath = manifestPath
+        self.jobFolder = os.path.dirname(manifestPath)
+        self.manifest = _readJson(manifestPath)
+
+        self.frames = {}
+        for frame in self.manifest["frames"]:
+            self.frames[_frameKey(frame)] = {"frame": frame, "state": STATE_PENDING, "attempts": 0}
+
+        # [(process, frameKeys, logFile)]
+        self.running = []
+        self.workerIndex = 0
+
+    def run(self):
+        self.writeStatus()
+
+        while True:
+            self.collectFinishedWorkers()
+
+            while len(self.running) < self.manifest["workers"]:
+                chunk = self.nextChunk()
+                if not chunk:
+                    break
+                self.startWorker(chunk)
+
+            self.writeStatus()
+
+            if not self.running and not self.pendingFrames():
+                break
+
+            time.sleep(POLL_INTERVAL)
+
+        self.writeStatus(finished=True)
+
+    def pendingFrames(self):
+        return [key for key, info in self.frames.items() if info["state"] == STATE_PENDING]
+
+    def nextChunk(self):
+        pending = self.pendingFrames()
+        pending.sort(key=lambda key: self.frames[key]["frame"])
+        return pending[:self.manifest["framesPerChunk"]]
+
+    def startWorker(self, chunk):
+        frames = [self.frames[key]["frame"] for key in chunk]
+        for key in chunk:
+            self.frames[key]["state"] = STATE_RUNNING
+            self.frames[key]["attempts"] += 1
+
+        # Forward slashes survive both Python string and MEL string quoting
+        pythonCmd = "import sys; sys.path.insert(0, '%s'); import rprUsdDistributedRender; " \
+                    "rprUsdDistributedRender.renderChunk('%s', %s)" % (
+                        self.manifest["scriptsPath"].replace("\\", "/"),
+                        self.manifestPath.replace("\\", "/"),
+                        repr(frames))
+        melCmd = "python(\"%s\")" % pythonCmd
+
+        logPath = os.path.join(self.jobFolder, LOGS_FOLDER_NAME, "worker_%d.log" % self.workerIndex)
+        self.workerIndex += 1
+        logFile = open(logPath, "w")
+
+        process = subprocess.Popen(
+            [self.manifest["mayaBatch"], "-batch",
+             "-proj", self.manifest["project"],
+             "-file", self.manifest["sceneFile"],
+             "-command", melCmd],
+            stdout=logFile,
+            stderr=subprocess.STDOUT)
+
+        self.running.append((process, chunk, logFile))
+
+    def collectFinishedWorkers(self):
+        stillRunning = []
+        for process, chunk, logFile in self.running:
+            if process.poll() is None:
+                stillRunning.append((process, chunk, logFile))
+                continue
+
+            logFile.close()
+
+            for key in chunk:
+                info = self.frames[key]
+                resultPath = _resultPath(self.jobFolder, info["frame"])
+
+                result = None
+                if os.path.exists(resultPath):
+                    try:
+                        result = _readJson(resultPath)
+                    except ValueError:
+                        result = None
+
+                if result and result["state"] == STATE_DONE:
+                    info["state"] = STATE_DONE
+                    info["renderTime"] = result["renderTime"]
+                    continue
+
+                # Worker crashed or the frame failed, try again on another worker
+                info["error"] = result["error"] if result else \
+                    "worker exited with code %d" % process.returncode
+                if info["attempts"] < self.manifest["maxAttempts"]:
+                    info["state"] = STATE_PENDING
+                    if result:
+                        os.remove(resultPath)
+                else:
+                    info["state"] = STATE_FAILED
+
+        self.running = stillRunning
+
+    def writeStatus(self, finished=False):
+        counts = {STATE_PENDING: 0, STATE_RUNNING: 0, STATE_DONE: 0, STATE_FAILED: 0}
+        for info in self.frames.values():
+            counts[info["state"]] += 1
+
+        _writeJson(os.path.join(self.jobFolder, STATUS_FILE_NAME), {
+            "finished": finished,
+            "counts": counts,
+            "frames": sorted(self.frames.values(), key=lambda info: info["frame"]),
+        })
+
+
+if __name__ == "__main__":
+    Scheduler(sys.argv[1]).run()